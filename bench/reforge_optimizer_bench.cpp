@@ -0,0 +1,118 @@
+/*
+ * Credits: silviu20092
+ */
+
+/*
+ * 重铸推荐基准测试, 独立程序, 不随模块编译.
+ * 随机生成若干套装备(每件两项可重铸属性), 按 ItemReforge::SuggestReforges 的规则
+ * 列出候选项后运行 ReforgeOptimizer, 统计每次推荐的耗时和候选项数.
+ * 属性权重和上限与 Reforging.Optimizer.Weights/Caps 的默认值相同.
+ *
+ * g++ -std=c++17 -O2 -I<azerothcore>/src/common -I../src -o reforge_optimizer_bench \
+ *     reforge_optimizer_bench.cpp ../src/reforge_optimizer.cpp
+ * ./reforge_optimizer_bench [runs]
+ */
+
+#include "reforge_optimizer.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+static constexpr uint32 GEAR_SETS = 64;
+static constexpr uint8 REFORGEABLE_ITEMS = 16;
+static constexpr uint32 REFORGE_PERCENTAGE = 40;
+
+struct BenchStat
+{
+    float weight;
+    int32 cap;
+};
+
+// 命中, 精准, 爆击, 急速, 护甲穿透, 法力回复, 精神
+static const std::array<BenchStat, 7> stats = {{
+    { 1.0f, 263 }, { 0.9f, 214 }, { 0.8f, 0 }, { 0.8f, 0 }, { 0.7f, 0 }, { 0.3f, 0 }, { 0.2f, 0 }
+}};
+
+struct BenchItem
+{
+    std::array<uint8, 2> stat;
+    std::array<uint32, 2> value;
+};
+
+struct GearSet
+{
+    std::array<int32, stats.size()> rating;
+    std::array<BenchItem, REFORGEABLE_ITEMS> items;
+};
+
+static float Suggest(const GearSet& gear, size_t& evaluated)
+{
+    ReforgeOptimizer optimizer(stats.size());
+    for (uint32 i = 0; i < stats.size(); ++i)
+        optimizer.SetStat(i, stats[i].weight, stats[i].cap ? gear.rating[i] : 0, stats[i].cap);
+
+    // 减少的属性在物品上, 增加的属性不在物品上
+    for (uint8 slot = 0; slot < REFORGEABLE_ITEMS; ++slot)
+    {
+        const BenchItem& item = gear.items[slot];
+        ReforgeOptimizer::Slot slotOptions;
+        slotOptions.slot = slot;
+        for (uint32 i = 0; i < item.stat.size(); ++i)
+        {
+            int32 value = int32(item.value[i] * REFORGE_PERCENTAGE / 100);
+            for (uint8 increase = 0; increase < stats.size(); ++increase)
+                if (increase != item.stat[0] && increase != item.stat[1])
+                    slotOptions.options.push_back({ item.stat[i], increase, value });
+        }
+        optimizer.AddSlot(std::move(slotOptions));
+    }
+
+    float total = optimizer.Solve();
+    for (const ReforgeOptimizer::Slot& slot : optimizer.GetSlots())
+        evaluated += slot.options.size();
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    uint32 runs = argc > 1 ? uint32(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    runs = std::max<uint32>(runs, 1);
+
+    std::mt19937 rng(20092);
+    std::uniform_int_distribution<uint32> statDist(0, stats.size() - 1);
+    std::uniform_int_distribution<uint32> valueDist(30, 120);
+    std::uniform_int_distribution<int32> ratingDist(150, 300);
+
+    std::vector<GearSet> gearSets(GEAR_SETS);
+    for (GearSet& gear : gearSets)
+    {
+        for (int32& rating : gear.rating)
+            rating = ratingDist(rng);
+
+        for (BenchItem& item : gear.items)
+        {
+            item.stat[0] = uint8(statDist(rng));
+            do
+                item.stat[1] = uint8(statDist(rng));
+            while (item.stat[1] == item.stat[0]);
+            item.value = { valueDist(rng), valueDist(rng) };
+        }
+    }
+
+    size_t evaluated = 0;
+    float gain = 0.0f;
+    Clock::time_point start = Clock::now();
+    for (uint32 i = 0; i < runs; ++i)
+        gain += Suggest(gearSets[i % GEAR_SETS], evaluated);
+    uint64 elapsed = uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+
+    std::printf("%u suggestions over %u gear sets of %u items: %.2f us each, %zu candidate options per set, %.1f average weighted gain\n",
+        runs, GEAR_SETS, REFORGEABLE_ITEMS, double(elapsed) / 1000.0 / runs, evaluated / runs, gain / runs);
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * Credits: silviu20092
+ */
+
+/*
+ * 拥有者索引基准测试, 独立程序, 不随模块编译.
+ * 按 ItemReforge 的常驻数据布局(ReforgeFlatMap 加 guid -> item_guid 列表的拥有者索引)
+ * 建一张临时表, 比较按角色查询/删除时走拥有者索引与扫描整张表的耗时.
+ *
+ * g++ -std=c++17 -O2 -I<azerothcore>/src/common -I../src -o reforge_owner_index_bench \
+ *     reforge_owner_index_bench.cpp ../src/reforge_flat_map.cpp
+ * ./reforge_owner_index_bench [rows] [queries]
+ */
+
+#include "reforge_flat_map.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <unordered_map>
+#include <vector>
+
+typedef std::unordered_map<uint32, std::vector<uint32>> OwnerIndexContainer;
+typedef std::chrono::steady_clock Clock;
+
+static constexpr uint32 ROWS_PER_OWNER = 12;
+static constexpr uint32 MAX_SCANS = 16;
+
+static uint64 Elapsed(Clock::time_point start)
+{
+    return uint64(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+int main(int argc, char** argv)
+{
+    uint32 rows = argc > 1 ? uint32(std::strtoul(argv[1], nullptr, 10)) : 5000000;
+    uint32 queries = argc > 2 ? uint32(std::strtoul(argv[2], nullptr, 10)) : 1000;
+    rows = std::max<uint32>(rows, 1000);
+
+    // 每个角色约 ROWS_PER_OWNER 条, 同一角色的 item_guid 分散在整个表里
+    uint32 owners = std::max<uint32>(rows / ROWS_PER_OWNER, 2);
+    ReforgeFlatMap table;
+    OwnerIndexContainer index;
+
+    Clock::time_point start = Clock::now();
+    table.Reserve(rows);
+    index.reserve(owners);
+    for (uint32 i = 0; i < rows; ++i)
+    {
+        uint32 itemGuid = i + 1;
+        uint32 owner = 1 + uint32((uint64(i) * 2654435761ULL) % owners);
+        table.Insert(itemGuid, owner, uint8(6 + i % 40), uint8(31 + i % 7), uint16(i % 500 + 1));
+        index[owner].push_back(itemGuid);
+    }
+    uint64 buildTime = Elapsed(start);
+
+    size_t memoryUsage = table.MemoryUsage();
+    for (const auto& [guid, items] : index)
+        memoryUsage += sizeof(guid) + sizeof(items) + items.capacity() * sizeof(uint32);
+
+    // 查询和删除用两组互不相交的角色: 1 + k * step 与 2 + k * step
+    queries = std::clamp<uint32>(queries, 1, owners / 2);
+    uint32 scans = std::min(queries, MAX_SCANS);
+    uint32 step = owners / queries;
+
+    std::vector<ReforgeFlatMap::Record> found;
+    start = Clock::now();
+    for (uint32 k = 0; k < queries; ++k)
+    {
+        found.clear();
+        OwnerIndexContainer::const_iterator itr = index.find(1 + k * step);
+        if (itr == index.end())
+            continue;
+
+        for (uint32 itemGuid : itr->second)
+            if (const ReforgeFlatMap::Record* record = table.Find(itemGuid))
+                found.push_back(*record);
+    }
+    uint64 indexQueryTime = Elapsed(start);
+
+    // 没有拥有者索引时只能扫描整个表
+    start = Clock::now();
+    for (uint32 k = 0; k < scans; ++k)
+    {
+        uint32 guid = 1 + k * step;
+        found.clear();
+        table.ForEach([&found, guid](const ReforgeFlatMap::Record& record, uint32 owner)
+        {
+            if (owner == guid)
+                found.push_back(record);
+        });
+    }
+    uint64 scanQueryTime = Elapsed(start);
+
+    uint32 deletedRows = 0;
+    start = Clock::now();
+    for (uint32 k = 0; k < queries; ++k)
+    {
+        OwnerIndexContainer::iterator itr = index.find(2 + k * step);
+        if (itr == index.end())
+            continue;
+
+        for (uint32 itemGuid : itr->second)
+            deletedRows += table.Erase(itemGuid) ? 1 : 0;
+        index.erase(itr);
+    }
+    uint64 indexDeleteTime = Elapsed(start);
+
+    // 后移删除会移动记录, 先收集再删除
+    std::vector<uint32> doomed;
+    start = Clock::now();
+    for (uint32 k = 0; k < scans; ++k)
+    {
+        uint32 guid = 3 + k * step;
+        doomed.clear();
+        table.ForEach([&doomed, guid](const ReforgeFlatMap::Record& record, uint32 owner)
+        {
+            if (owner == guid)
+                doomed.push_back(record.item_guid);
+        });
+
+        for (uint32 itemGuid : doomed)
+            table.Erase(itemGuid);
+    }
+    uint64 scanDeleteTime = Elapsed(start);
+
+    std::printf("%u rows across %u characters, built in %llu ms, %zu KB\n", rows, owners, (unsigned long long)(buildTime / 1000), memoryUsage / 1024);
+    std::printf("per-character query: %.2f us with the owner index (x%u), %.1f us by full scan (x%u)\n",
+        double(indexQueryTime) / queries, queries, double(scanQueryTime) / scans, scans);
+    std::printf("per-character delete: %.2f us with the owner index (x%u, %u rows), %.1f us by full scan (x%u)\n",
+        double(indexDeleteTime) / queries, queries, deletedRows, double(scanDeleteTime) / scans, scans);
+    return 0;
+}
@@ -0,0 +1,220 @@
+/*
+ * Credits: silviu20092
+ */
+
+/*
+ * 菜单文本基准测试, 独立程序, 不随模块编译.
+ * 按装备栏位菜单的行格式(栏位图标, 栏位名, 物品图标和物品链接)生成文本,
+ * 比较原来用 std::string/ostringstream 拼接与写进 ReforgeTextBuffer 的耗时和堆分配次数.
+ * 独立程序可以替换全局 operator new 来统计分配, 模块里不能这样做.
+ *
+ * g++ -std=c++17 -O2 -I<azerothcore>/src/common -I../src -o reforge_text_bench \
+ *     reforge_text_bench.cpp ../src/reforge_text.cpp
+ * ./reforge_text_bench [menus]
+ */
+
+#include "reforge_text.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <sstream>
+#include <string>
+
+static std::atomic<uint64> allocations{0};
+
+void* operator new(size_t size)
+{
+    ++allocations;
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
+
+typedef std::chrono::steady_clock Clock;
+
+static constexpr size_t MAX_ITEM_LINK_LENGTH = 512;
+static constexpr uint8 SLOT_COUNT = 19;
+static constexpr const char* RED_COLOR = "b50505";
+
+struct BenchItem
+{
+    uint32 entry;
+    uint32 qualityColor;
+    const char* icon;
+    const char* name;
+};
+
+static const std::array<const char*, SLOT_COUNT> slotIcons = {
+    "UI-PaperDoll-Slot-Head", "UI-PaperDoll-Slot-Neck", "UI-PaperDoll-Slot-Shoulder", "UI-PaperDoll-Slot-Shirt",
+    "UI-PaperDoll-Slot-Chest", "UI-PaperDoll-Slot-Waist", "UI-PaperDoll-Slot-Legs", "UI-PaperDoll-Slot-Feet",
+    "UI-PaperDoll-Slot-Wrists", "UI-PaperDoll-Slot-Hands", "UI-PaperDoll-Slot-Finger", "UI-PaperDoll-Slot-Finger",
+    "UI-PaperDoll-Slot-Trinket", "UI-PaperDoll-Slot-Trinket", "UI-PaperDoll-Slot-Chest", "UI-PaperDoll-Slot-MainHand",
+    "UI-PaperDoll-Slot-SecondaryHand", "UI-PaperDoll-Slot-Ranged", "UI-PaperDoll-Slot-Tabard"
+};
+
+static const std::array<const char*, SLOT_COUNT> slotNames = {
+    "头部", "颈部", "肩部", "衬衣", "胸部", "腰部", "腿部", "脚", "手腕", "手",
+    "手指 1", "手指 2", "饰品 1", "饰品 2", "背部", "主手", "副手", "远程", "战袍"
+};
+
+// 衬衣和战袍栏位为空
+static const std::array<BenchItem, SLOT_COUNT> equipment = {{
+    { 51227, 0xffa335ee, "INV_Helmet_151", "Sanctified Ymirjar Lord's Helmet" },
+    { 50633, 0xffa335ee, "INV_Jewelry_Necklace_Ahnqiraj_02", "Sindragosa's Cruel Claw" },
+    { 51229, 0xffa335ee, "INV_Shoulder_124", "Sanctified Ymirjar Lord's Shoulderplates" },
+    { 0, 0, nullptr, nullptr },
+    { 51225, 0xffa335ee, "INV_Chest_Plate_26", "Sanctified Ymirjar Lord's Battleplate" },
+    { 50620, 0xffa335ee, "INV_Belt_61", "Coldwraith Links" },
+    { 51228, 0xffa335ee, "INV_Pants_Plate_37", "Sanctified Ymirjar Lord's Legplates" },
+    { 54578, 0xffa335ee, "INV_Boots_Plate_14", "Apocalypse's Advance" },
+    { 50659, 0xffa335ee, "INV_Bracer_45", "Polar Bear Claw Bracers" },
+    { 51226, 0xffa335ee, "INV_Gauntlets_91", "Sanctified Ymirjar Lord's Gauntlets" },
+    { 50693, 0xffa335ee, "INV_Jewelry_Ring_81", "Might of Blight" },
+    { 52572, 0xffa335ee, "INV_Jewelry_Ring_85", "Ashen Band of Endless Might" },
+    { 54590, 0xffa335ee, "INV_Misc_Bone_Elfskull_01", "Sharpened Twilight Scale" },
+    { 50363, 0xffa335ee, "INV_Jewelry_Talisman_13", "Deathbringer's Will" },
+    { 50677, 0xffa335ee, "INV_Misc_Cape_18", "Winding Sheet" },
+    { 50730, 0xffa335ee, "INV_Axe_113", "Glorenzelg, High-Blade of the Silver Hand" },
+    { 0, 0, nullptr, nullptr },
+    { 50733, 0xffa335ee, "INV_Misc_Bone_10", "Fal'inrush, Defender of Quel'thalas" },
+    { 0, 0, nullptr, nullptr }
+}};
+
+// 原来的写法: 每个部件返回一个 std::string
+static std::string SlotIcon(uint8 slot, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0)
+{
+    std::ostringstream ss;
+    ss << "|TInterface/PaperDoll/" << slotIcons[slot] << ":" << width << ":" << height << ":" << x << ":" << y << "|t";
+    return ss.str();
+}
+
+static std::string TextWithColor(const std::string& text, const std::string& color)
+{
+    return "|cff" + color + text + "|r";
+}
+
+static std::string ItemIcon(const BenchItem& item, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0)
+{
+    std::ostringstream ss;
+    ss << "|TInterface/ICONS/" << item.icon << ":" << width << ":" << height << ":" << x << ":" << y << "|t";
+    return ss.str();
+}
+
+static std::string ItemName(const BenchItem& item)
+{
+    std::string name = item.name;
+    return name;
+}
+
+static std::string ItemLink(const BenchItem& item)
+{
+    std::stringstream oss;
+    oss << "|c" << std::hex << item.qualityColor << std::dec;
+    oss << "|Hitem:" << item.entry << ":0:0:0:0:0:0:0:0:0|h[" << ItemName(item) << "]|h|r";
+    return oss.str();
+}
+
+static std::string ItemLinkForUI(const BenchItem& item)
+{
+    std::ostringstream oss;
+    oss << ItemIcon(item) << ItemLink(item);
+    return oss.str();
+}
+
+static std::string StringLine(uint8 slot)
+{
+    std::string text = SlotIcon(slot) + slotNames[slot] + " [";
+    if (equipment[slot].entry)
+        text += ItemLinkForUI(equipment[slot]);
+    else
+        text += TextWithColor("无物品", RED_COLOR);
+    text += "]";
+    return text;
+}
+
+// 现在的写法: 整行写进栈上的定长缓冲区
+static void BufferLine(ReforgeTextWriter& text, uint8 slot)
+{
+    text.Append("|TInterface/PaperDoll/").Append(slotIcons[slot]).Append(":30:30:0:0|t");
+    text.Append(slotNames[slot]).Append(" [");
+    if (const BenchItem& item = equipment[slot]; item.entry)
+    {
+        text.Append("|TInterface/ICONS/").Append(item.icon);
+        text.Append(':').AppendNumber(30).Append(':').AppendNumber(30).Append(':').AppendNumber(0).Append(':').AppendNumber(0).Append("|t");
+        text.Append("|c").AppendHex(item.qualityColor);
+        text.Append("|Hitem:").AppendNumber(item.entry).Append(":0:0:0:0:0:0:0:0:0|h[").Append(item.name).Append("]|h|r");
+    }
+    else
+        text.AppendColored("无物品", RED_COLOR);
+    text.Append(']');
+}
+
+static size_t StringMenu()
+{
+    size_t length = 0;
+    for (uint8 slot = 0; slot < SLOT_COUNT; slot++)
+        length += StringLine(slot).size();
+    return length;
+}
+
+static size_t BufferMenu()
+{
+    size_t length = 0;
+    for (uint8 slot = 0; slot < SLOT_COUNT; slot++)
+    {
+        ReforgeTextBuffer<MAX_ITEM_LINK_LENGTH> text;
+        BufferLine(text, slot);
+        length += text.GetLength();
+    }
+    return length;
+}
+
+template<typename F>
+static void Run(const char* label, uint32 menus, F&& build)
+{
+    size_t length = 0;
+    uint64 before = allocations.load();
+    Clock::time_point start = Clock::now();
+    for (uint32 i = 0; i < menus; ++i)
+        length += build();
+    uint64 elapsed = uint64(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+    uint64 allocated = allocations.load() - before;
+
+    std::printf("%-13s %.2f us per menu, %.1f allocations per menu (%zu bytes of text)\n",
+        label, double(elapsed) / menus, double(allocated) / menus, length / menus);
+}
+
+int main(int argc, char** argv)
+{
+    uint32 menus = argc > 1 ? uint32(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    if (!menus)
+        menus = 1;
+
+    for (uint8 slot = 0; slot < SLOT_COUNT; slot++)
+    {
+        ReforgeTextBuffer<MAX_ITEM_LINK_LENGTH> text;
+        BufferLine(text, slot);
+        if (text.IsTruncated() || text.View() != StringLine(slot))
+        {
+            std::printf("slot %u: the two builders produce different text\n", slot);
+            return 1;
+        }
+    }
+
+    Run("std::string:", menus, StringMenu);
+    Run("text buffer:", menus, BufferMenu);
+    return 0;
+}
@@ -5,5 +5,6 @@ CREATE TABLE `character_reforging`(
 	`stat_decrease` int unsigned not null,
     `stat_increase` int unsigned not null,
     `stat_value` int unsigned not null,
-    PRIMARY KEY (`item_guid`)
+    PRIMARY KEY (`item_guid`),
+    KEY `idx_guid` (`guid`)
 ) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
\ No newline at end of file
@@ -0,0 +1,7 @@
+CREATE TABLE IF NOT EXISTS `character_reforging_generation`(
+	`id` tinyint unsigned not null,
+	`generation` bigint unsigned not null,
+    PRIMARY KEY (`id`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
+
+INSERT IGNORE INTO `character_reforging_generation` (`id`, `generation`) VALUES (0, 0);
@@ -0,0 +1,6 @@
+-- character_reforging 按角色读取和删除时使用的索引, 已存在则跳过
+SET @IndexExists = (SELECT COUNT(*) FROM `information_schema`.`STATISTICS` WHERE `TABLE_SCHEMA` = DATABASE() AND `TABLE_NAME` = 'character_reforging' AND `INDEX_NAME` = 'idx_guid');
+SET @Sql = IF(@IndexExists = 0, 'ALTER TABLE `character_reforging` ADD KEY `idx_guid` (`guid`)', 'DO 0');
+PREPARE stmt FROM @Sql;
+EXECUTE stmt;
+DEALLOCATE PREPARE stmt;
@@ -0,0 +1,71 @@
+CREATE TABLE IF NOT EXISTS `mod_reforging_strings`(
+	`type` tinyint unsigned not null,
+	`id` int unsigned not null,
+	`locale` varchar(4) not null,
+	`text` varchar(100) not null,
+    PRIMARY KEY (`type`, `id`, `locale`)
+) ENGINE=InnoDB DEFAULT CHARSET=utf8mb4 COLLATE=utf8mb4_unicode_ci;
+
+-- type 0: ItemModType 属性名称, type 1: 装备栏位名称
+DELETE FROM `mod_reforging_strings` WHERE `locale` = 'enUS';
+INSERT INTO `mod_reforging_strings` (`type`, `id`, `locale`, `text`) VALUES
+(0, 0, 'enUS', 'Mana'),
+(0, 1, 'enUS', 'Health'),
+(0, 3, 'enUS', 'Agility'),
+(0, 4, 'enUS', 'Strength'),
+(0, 5, 'enUS', 'Intellect'),
+(0, 6, 'enUS', 'Spirit'),
+(0, 7, 'enUS', 'Stamina'),
+(0, 12, 'enUS', 'Defense'),
+(0, 13, 'enUS', 'Dodge'),
+(0, 14, 'enUS', 'Parry'),
+(0, 15, 'enUS', 'Block'),
+(0, 16, 'enUS', 'Melee Hit'),
+(0, 17, 'enUS', 'Ranged Hit'),
+(0, 18, 'enUS', 'Spell Hit'),
+(0, 19, 'enUS', 'Melee Crit'),
+(0, 20, 'enUS', 'Ranged Crit'),
+(0, 21, 'enUS', 'Spell Crit'),
+(0, 22, 'enUS', 'Melee Hit Taken'),
+(0, 23, 'enUS', 'Ranged Hit Taken'),
+(0, 24, 'enUS', 'Spell Hit Taken'),
+(0, 25, 'enUS', 'Melee Crit Taken'),
+(0, 26, 'enUS', 'Ranged Crit Taken'),
+(0, 27, 'enUS', 'Spell Crit Taken'),
+(0, 28, 'enUS', 'Melee Haste'),
+(0, 29, 'enUS', 'Ranged Haste'),
+(0, 30, 'enUS', 'Spell Haste'),
+(0, 31, 'enUS', 'Hit'),
+(0, 32, 'enUS', 'Crit'),
+(0, 33, 'enUS', 'Hit Taken'),
+(0, 34, 'enUS', 'Crit Taken'),
+(0, 35, 'enUS', 'Resilience'),
+(0, 36, 'enUS', 'Haste'),
+(0, 37, 'enUS', 'Expertise'),
+(0, 38, 'enUS', 'Attack Power'),
+(0, 39, 'enUS', 'Ranged Attack Power'),
+(0, 43, 'enUS', 'Mana Regeneration'),
+(0, 44, 'enUS', 'Armor Penetration'),
+(0, 45, 'enUS', 'Spell Power'),
+(0, 46, 'enUS', 'Health Regeneration'),
+(0, 47, 'enUS', 'Spell Penetration'),
+(0, 48, 'enUS', 'Block Value'),
+(1, 0, 'enUS', 'Head'),
+(1, 1, 'enUS', 'Neck'),
+(1, 2, 'enUS', 'Shoulders'),
+(1, 3, 'enUS', 'Shirt'),
+(1, 4, 'enUS', 'Chest'),
+(1, 5, 'enUS', 'Waist'),
+(1, 6, 'enUS', 'Legs'),
+(1, 7, 'enUS', 'Feet'),
+(1, 8, 'enUS', 'Wrists'),
+(1, 9, 'enUS', 'Hands'),
+(1, 10, 'enUS', 'Finger 1'),
+(1, 11, 'enUS', 'Finger 2'),
+(1, 12, 'enUS', 'Trinket 1'),
+(1, 13, 'enUS', 'Trinket 2'),
+(1, 14, 'enUS', 'Back'),
+(1, 15, 'enUS', 'Main Hand'),
+(1, 16, 'enUS', 'Off Hand'),
+(1, 17, 'enUS', 'Ranged'),
+(1, 18, 'enUS', 'Tabard');
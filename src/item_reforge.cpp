@@ -3,127 +3,313 @@
  */
 
 #include <cmath>
+#include <cstdlib>
 #include "DatabaseEnv.h"
 #include "Player.h"
 #include "Chat.h"
 #include "Tokenize.h"
 #include "StringConvert.h"
+#include "StringFormat.h"
 #include "SpellMgr.h"
 #include "WorldSessionMgr.h"
+#include "ObjectAccessor.h"
 #include "item_reforge.h"
+#include "reforge_optimizer.h"
+#include "reforge_store.h"
 #include "Item.h"
+#include "Timer.h"
+#include "Log.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
 #include <unordered_map>
-#include <tuple>
-
- /*
-  * ItemReforge 实现：基于 item_instance 表的 reforge 字段实现装备实例级重铸
-  * 需在数据库 item_instance 表增加字段：
-  *   reforge_decrease INT DEFAULT 0,
-  *   reforge_increase INT DEFAULT 0,
-  *   reforge_value   INT DEFAULT 0
-  */
-
-  // 内存缓存每个 item 的重铸数据（可选加速）
-static std::unordered_map<uint64, std::tuple<uint32, uint32, uint32>> s_ReforgeCache;
 
+/*
+ * 旧版 item_instance 接口: 数据已统一保存在 character_reforging, 这些函数只是 ReforgeStore 的包装.
+ */
 
 void ItemReforge::SetReforgeData(Item* item, uint32 decrease, uint32 increase, uint32 value)
 {
     if (!item) return;
-    CharacterDatabase.Execute(
-        "UPDATE item_instance SET reforge_decrease = {}, reforge_increase = {}, reforge_value = {} WHERE guid = {}",
-        decrease, increase, value, item->GetGUID().GetCounter()
-    );
+    if (decrease == 0 && increase == 0 && value == 0)
+    {
+        ClearReforgeData(item);
+        return;
+    }
+
+    ReforgingData reforgingData;
+    reforgingData.guid = item->GetOwnerGUID().GetCounter();
+    reforgingData.item_guid = item->GetGUID().GetCounter();
+    reforgingData.stat_decrease = decrease;
+    reforgingData.stat_increase = increase;
+    reforgingData.stat_value = value;
+    sReforgeStore->Set(reforgingData);
 }
 
 void ItemReforge::ClearReforgeData(Item* item)
 {
     if (!item) return;
-    CharacterDatabase.Execute(
-        "UPDATE item_instance SET reforge_decrease = 0, reforge_increase = 0, reforge_value = 0 WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
+    sReforgeStore->Remove(item->GetGUID().GetCounter(), item->GetOwnerGUID().GetCounter());
 }
 
 bool ItemReforge::HasReforge(const Item* item)
 {
-    if (!item) return false;
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT reforge_decrease, reforge_increase, reforge_value FROM item_instance WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
-    if (!result) return false;
-    Field* fields = result->Fetch();
-    return fields[0].Get<uint32>() != 0 || fields[1].Get<uint32>() != 0 || fields[2].Get<uint32>() != 0;
+    return item && sReforgeStore->Contains(item->GetGUID().GetCounter());
 }
 
 uint32 ItemReforge::GetReforgeDecrease(const Item* item)
 {
-    if (!item) return 0;
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT reforge_decrease FROM item_instance WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
-    if (!result) return 0;
-    return result->Fetch()[0].Get<uint32>();
+    uint32 decrease, increase, value;
+    LoadFromDB(item, decrease, increase, value);
+    return decrease;
 }
 
 uint32 ItemReforge::GetReforgeIncrease(const Item* item)
 {
-    if (!item) return 0;
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT reforge_increase FROM item_instance WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
-    if (!result) return 0;
-    return result->Fetch()[0].Get<uint32>();
+    uint32 decrease, increase, value;
+    LoadFromDB(item, decrease, increase, value);
+    return increase;
 }
 
 uint32 ItemReforge::GetReforgeValue(const Item* item)
 {
-    if (!item) return 0;
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT reforge_value FROM item_instance WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
-    if (!result) return 0;
-    return result->Fetch()[0].Get<uint32>();
+    uint32 decrease, increase, value;
+    LoadFromDB(item, decrease, increase, value);
+    return value;
 }
 
 void ItemReforge::SaveToDB(Item* item, uint32 decrease, uint32 increase, uint32 value)
 {
-    if (!item) return;
-    CharacterDatabase.Execute(
-        "UPDATE item_instance SET reforge_decrease = {}, reforge_increase = {}, reforge_value = {} WHERE guid = {}",
-        decrease, increase, value, item->GetGUID().GetCounter()
-    );
+    SetReforgeData(item, decrease, increase, value);
 }
 
 bool ItemReforge::LoadFromDB(const Item* item, uint32& decrease, uint32& increase, uint32& value)
 {
-    if (!item) return false;
-    QueryResult result = CharacterDatabase.Query(
-        "SELECT reforge_decrease, reforge_increase, reforge_value FROM item_instance WHERE guid = {}",
-        item->GetGUID().GetCounter()
-    );
-    if (result)
+    std::optional<ReforgingData> reforgingData = item ? sReforgeStore->Get(item->GetGUID().GetCounter()) : std::nullopt;
+    if (reforgingData)
     {
-        Field* fields = result->Fetch();
-        decrease = fields[0].Get<uint32>();
-        increase = fields[1].Get<uint32>();
-        value = fields[2].Get<uint32>();
-        s_ReforgeCache[item->GetGUID().GetCounter()] = std::make_tuple(decrease, increase, value);
+        decrease = reforgingData->stat_decrease;
+        increase = reforgingData->stat_increase;
+        value = reforgingData->stat_value;
         return true;
     }
     decrease = increase = value = 0;
     return false;
 }
 
+/*
+ * 每种 ItemModType 对应的属性效果, 复合属性(命中/暴击/急速等)展开为多个效果.
+ * 新增可重铸属性时只需要在这里和 STAT_NAMES 里各加一行.
+ */
+namespace
+{
+    enum class StatEffectType : uint8
+    {
+        NONE,
+        STAT,               // 基础属性, 同时修改 UnitMods 和属性加成
+        UNIT_MOD_BASE,
+        UNIT_MOD_TOTAL,
+        RATING,
+        MANA_REGEN,
+        SPELL_POWER,
+        HEALTH_REGEN,
+        SPELL_PENETRATION,
+        BLOCK_VALUE
+    };
+
+    struct StatEffect
+    {
+        StatEffectType type;
+        uint8 target;
+    };
+
+    struct StatEffects
+    {
+        uint8 count;
+        std::array<StatEffect, 3> effects;
+    };
+
+    struct StatName
+    {
+        uint32 statType;
+        const char* name;
+    };
+
+    constexpr uint32 MAX_STAT_EFFECT_TYPE = ITEM_MOD_BLOCK_VALUE + 1;
+
+    constexpr std::array<StatEffects, MAX_STAT_EFFECT_TYPE> BuildStatEffects()
+    {
+        std::array<StatEffects, MAX_STAT_EFFECT_TYPE> table = {};
+        auto add = [&table](uint32 statType, StatEffectType type, uint8 target)
+        {
+            StatEffects& effects = table[statType];
+            effects.effects[effects.count++] = { type, target };
+        };
+
+        add(ITEM_MOD_MANA, StatEffectType::UNIT_MOD_BASE, UNIT_MOD_MANA);
+        add(ITEM_MOD_HEALTH, StatEffectType::UNIT_MOD_BASE, UNIT_MOD_HEALTH);
+        add(ITEM_MOD_AGILITY, StatEffectType::STAT, STAT_AGILITY);
+        add(ITEM_MOD_STRENGTH, StatEffectType::STAT, STAT_STRENGTH);
+        add(ITEM_MOD_INTELLECT, StatEffectType::STAT, STAT_INTELLECT);
+        add(ITEM_MOD_SPIRIT, StatEffectType::STAT, STAT_SPIRIT);
+        add(ITEM_MOD_STAMINA, StatEffectType::STAT, STAT_STAMINA);
+        add(ITEM_MOD_DEFENSE_SKILL_RATING, StatEffectType::RATING, CR_DEFENSE_SKILL);
+        add(ITEM_MOD_DODGE_RATING, StatEffectType::RATING, CR_DODGE);
+        add(ITEM_MOD_PARRY_RATING, StatEffectType::RATING, CR_PARRY);
+        add(ITEM_MOD_BLOCK_RATING, StatEffectType::RATING, CR_BLOCK);
+        add(ITEM_MOD_HIT_MELEE_RATING, StatEffectType::RATING, CR_HIT_MELEE);
+        add(ITEM_MOD_HIT_RANGED_RATING, StatEffectType::RATING, CR_HIT_RANGED);
+        add(ITEM_MOD_HIT_SPELL_RATING, StatEffectType::RATING, CR_HIT_SPELL);
+        add(ITEM_MOD_CRIT_MELEE_RATING, StatEffectType::RATING, CR_CRIT_MELEE);
+        add(ITEM_MOD_CRIT_RANGED_RATING, StatEffectType::RATING, CR_CRIT_RANGED);
+        add(ITEM_MOD_CRIT_SPELL_RATING, StatEffectType::RATING, CR_CRIT_SPELL);
+        add(ITEM_MOD_HIT_TAKEN_MELEE_RATING, StatEffectType::RATING, CR_HIT_TAKEN_MELEE);
+        add(ITEM_MOD_HIT_TAKEN_RANGED_RATING, StatEffectType::RATING, CR_HIT_TAKEN_RANGED);
+        add(ITEM_MOD_HIT_TAKEN_SPELL_RATING, StatEffectType::RATING, CR_HIT_TAKEN_SPELL);
+        add(ITEM_MOD_CRIT_TAKEN_MELEE_RATING, StatEffectType::RATING, CR_CRIT_TAKEN_MELEE);
+        add(ITEM_MOD_CRIT_TAKEN_RANGED_RATING, StatEffectType::RATING, CR_CRIT_TAKEN_RANGED);
+        add(ITEM_MOD_CRIT_TAKEN_SPELL_RATING, StatEffectType::RATING, CR_CRIT_TAKEN_SPELL);
+        add(ITEM_MOD_HASTE_MELEE_RATING, StatEffectType::RATING, CR_HASTE_MELEE);
+        add(ITEM_MOD_HASTE_RANGED_RATING, StatEffectType::RATING, CR_HASTE_RANGED);
+        add(ITEM_MOD_HASTE_SPELL_RATING, StatEffectType::RATING, CR_HASTE_SPELL);
+        for (uint8 rating : { CR_HIT_MELEE, CR_HIT_RANGED, CR_HIT_SPELL })
+            add(ITEM_MOD_HIT_RATING, StatEffectType::RATING, rating);
+        for (uint8 rating : { CR_CRIT_MELEE, CR_CRIT_RANGED, CR_CRIT_SPELL })
+            add(ITEM_MOD_CRIT_RATING, StatEffectType::RATING, rating);
+        for (uint8 rating : { CR_HIT_TAKEN_MELEE, CR_HIT_TAKEN_RANGED, CR_HIT_TAKEN_SPELL })
+            add(ITEM_MOD_HIT_TAKEN_RATING, StatEffectType::RATING, rating);
+        for (uint8 rating : { CR_CRIT_TAKEN_MELEE, CR_CRIT_TAKEN_RANGED, CR_CRIT_TAKEN_SPELL })
+        {
+            add(ITEM_MOD_CRIT_TAKEN_RATING, StatEffectType::RATING, rating);
+            add(ITEM_MOD_RESILIENCE_RATING, StatEffectType::RATING, rating);
+        }
+        for (uint8 rating : { CR_HASTE_MELEE, CR_HASTE_RANGED, CR_HASTE_SPELL })
+            add(ITEM_MOD_HASTE_RATING, StatEffectType::RATING, rating);
+        add(ITEM_MOD_EXPERTISE_RATING, StatEffectType::RATING, CR_EXPERTISE);
+        add(ITEM_MOD_ATTACK_POWER, StatEffectType::UNIT_MOD_TOTAL, UNIT_MOD_ATTACK_POWER);
+        add(ITEM_MOD_ATTACK_POWER, StatEffectType::UNIT_MOD_TOTAL, UNIT_MOD_ATTACK_POWER_RANGED);
+        add(ITEM_MOD_RANGED_ATTACK_POWER, StatEffectType::UNIT_MOD_TOTAL, UNIT_MOD_ATTACK_POWER_RANGED);
+        add(ITEM_MOD_MANA_REGENERATION, StatEffectType::MANA_REGEN, 0);
+        add(ITEM_MOD_ARMOR_PENETRATION_RATING, StatEffectType::RATING, CR_ARMOR_PENETRATION);
+        add(ITEM_MOD_SPELL_POWER, StatEffectType::SPELL_POWER, 0);
+        add(ITEM_MOD_HEALTH_REGEN, StatEffectType::HEALTH_REGEN, 0);
+        add(ITEM_MOD_SPELL_PENETRATION, StatEffectType::SPELL_PENETRATION, 0);
+        add(ITEM_MOD_BLOCK_VALUE, StatEffectType::BLOCK_VALUE, 0);
+        // ITEM_MOD_SPELL_HEALING_DONE / ITEM_MOD_SPELL_DAMAGE_DONE 已废弃, 没有效果
+        return table;
+    }
+
+    constexpr std::array<StatEffects, MAX_STAT_EFFECT_TYPE> STAT_EFFECTS = BuildStatEffects();
+
+    constexpr StatName STAT_NAMES[] = {
+        {ITEM_MOD_MANA, "法力"}, {ITEM_MOD_HEALTH, "治疗"}, {ITEM_MOD_AGILITY, "敏捷"},
+        {ITEM_MOD_STRENGTH, "力量"}, {ITEM_MOD_INTELLECT, "智力"}, {ITEM_MOD_SPIRIT, "精神"},
+        {ITEM_MOD_STAMINA, "耐力"}, {ITEM_MOD_DEFENSE_SKILL_RATING, "防御"}, {ITEM_MOD_DODGE_RATING, "躲闪"},
+        {ITEM_MOD_PARRY_RATING, "招架"}, {ITEM_MOD_BLOCK_RATING, "格挡"}, {ITEM_MOD_HIT_MELEE_RATING, "近战命中"},
+        {ITEM_MOD_HIT_RANGED_RATING, "远程命中"}, {ITEM_MOD_HIT_SPELL_RATING, "技能命中"}, {ITEM_MOD_CRIT_MELEE_RATING, "近战暴击"},
+        {ITEM_MOD_CRIT_RANGED_RATING, "远程暴击"}, {ITEM_MOD_CRIT_SPELL_RATING, "法术暴击"}, {ITEM_MOD_HIT_TAKEN_MELEE_RATING, "近战被命中"},
+        {ITEM_MOD_HIT_TAKEN_RANGED_RATING, "远程被命中"}, {ITEM_MOD_HIT_TAKEN_SPELL_RATING, "法术被命中"}, {ITEM_MOD_CRIT_TAKEN_MELEE_RATING, "近战被暴击"},
+        {ITEM_MOD_CRIT_TAKEN_RANGED_RATING, "远程被暴击"}, {ITEM_MOD_CRIT_TAKEN_SPELL_RATING, "法术被暴击"}, {ITEM_MOD_HASTE_MELEE_RATING, "近战急速"},
+        {ITEM_MOD_HASTE_RANGED_RATING, "远程急速"}, {ITEM_MOD_HASTE_SPELL_RATING, "法术急速"}, {ITEM_MOD_HIT_RATING, "命中"},
+        {ITEM_MOD_CRIT_RATING, "暴击"}, {ITEM_MOD_HIT_TAKEN_RATING, "被命中"}, {ITEM_MOD_CRIT_TAKEN_RATING, "被暴击"},
+        {ITEM_MOD_RESILIENCE_RATING, "韧性"}, {ITEM_MOD_HASTE_RATING, "急速"}, {ITEM_MOD_EXPERTISE_RATING, "精准"},
+        {ITEM_MOD_ATTACK_POWER, "近战攻强"}, {ITEM_MOD_RANGED_ATTACK_POWER, "远程攻强"}, {ITEM_MOD_MANA_REGENERATION, "法力恢复"},
+        {ITEM_MOD_ARMOR_PENETRATION_RATING, "护甲穿透"}, {ITEM_MOD_SPELL_POWER, "法术强度"}, {ITEM_MOD_HEALTH_REGEN, "生命恢复"},
+        {ITEM_MOD_SPELL_PENETRATION, "法术穿透"}, {ITEM_MOD_BLOCK_VALUE, "格挡值"}
+    };
+
+    constexpr bool AllStatNamesHaveEffects()
+    {
+        for (const StatName& statName : STAT_NAMES)
+            if (statName.statType >= MAX_STAT_EFFECT_TYPE || STAT_EFFECTS[statName.statType].count == 0)
+                return false;
+
+        return true;
+    }
+
+    static_assert(AllStatNamesHaveEffects(), "every stat in STAT_NAMES needs an entry in BuildStatEffects");
+    static_assert(MAX_STAT_EFFECT_TYPE == ItemReforge::MAX_STAT_NAMES, "stat name table and stat effect table must cover the same ItemModTypes");
+
+    constexpr const char* SLOT_NAMES[EQUIPMENT_SLOT_END] = {
+        "头部", "颈部", "肩膀", "衬衣", "胸部", "腰部", "腿部", "脚", "手腕", "手",
+        "手指一", "手指二", "饰品一", "饰品二", "披风", "主手", "副手", "远程", "战袍"
+    };
+
+    constexpr const char* SLOT_ICONS[EQUIPMENT_SLOT_END] = {
+        "UI-PaperDoll-Slot-Head", "UI-PaperDoll-Slot-Neck", "UI-PaperDoll-Slot-Shoulder", "UI-PaperDoll-Slot-Shirt",
+        "UI-PaperDoll-Slot-Chest", "UI-PaperDoll-Slot-Waist", "UI-PaperDoll-Slot-Legs", "UI-PaperDoll-Slot-Feet",
+        "UI-PaperDoll-Slot-Wrists", "UI-PaperDoll-Slot-Hands", "UI-PaperDoll-Slot-Finger", "UI-PaperDoll-Slot-Finger",
+        "UI-PaperDoll-Slot-Trinket", "UI-PaperDoll-Slot-Trinket", "UI-PaperDoll-Slot-Chest", "UI-PaperDoll-Slot-MainHand",
+        "UI-PaperDoll-Slot-SecondaryHand", "UI-PaperDoll-Slot-Ranged", "UI-PaperDoll-Slot-Tabard"
+    };
+
+    void ApplyStatEffect(Player* player, const StatEffect& effect, int32 val, bool apply)
+    {
+        switch (effect.type)
+        {
+            case StatEffectType::STAT:
+                player->HandleStatModifier(UnitMods(UNIT_MOD_STAT_START + effect.target), BASE_VALUE, float(val), apply);
+                player->ApplyStatBuffMod(Stats(effect.target), float(val), apply);
+                break;
+            case StatEffectType::UNIT_MOD_BASE:
+                player->HandleStatModifier(UnitMods(effect.target), BASE_VALUE, float(val), apply);
+                break;
+            case StatEffectType::UNIT_MOD_TOTAL:
+                player->HandleStatModifier(UnitMods(effect.target), TOTAL_VALUE, float(val), apply);
+                break;
+            case StatEffectType::RATING:
+                player->ApplyRatingMod(CombatRating(effect.target), int32(val), apply);
+                break;
+            case StatEffectType::MANA_REGEN:
+                player->ApplyManaRegenBonus(int32(val), apply);
+                break;
+            case StatEffectType::SPELL_POWER:
+                player->ApplySpellPowerBonus(int32(val), apply);
+                break;
+            case StatEffectType::HEALTH_REGEN:
+                player->ApplyHealthRegenBonus(int32(val), apply);
+                break;
+            case StatEffectType::SPELL_PENETRATION:
+                player->ApplySpellPenetrationBonus(val, apply);
+                break;
+            case StatEffectType::BLOCK_VALUE:
+                player->HandleBaseModValue(SHIELD_BLOCK_VALUE, FLAT_MOD, float(val), apply);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
 ItemReforge::ItemReforge()
 {
     enabled = true;
     percentage = PERCENTAGE_DEFAULT;
     NeedMoney = NEEDMONEY_DEFAULT;
+    itemPacketsBuilt = 0;
+    itemPacketsFromCache = 0;
+    itemPacketsSkipped = 0;
+    itemLinksBuilt = 0;
+    itemLinksFromCache = 0;
+    equippedReforgeEpoch = 0;
+    verifyDifferential = false;
+    differentialApplies = 0;
+    differentialApplyTime = 0;
+    fullApplies = 0;
+    fullApplyTime = 0;
+    differentialMismatches = 0;
+    optimizerWeights.fill(0.0f);
+    optimizerCaps.fill(0);
+    optimizerRuns = 0;
+    optimizerTime = 0;
+    optimizerMaxTime = 0;
+    FillDefaultStrings();
+    gossipSelections = 0;
+    configVersion = 0;
+    menusBuilt = 0;
+    menusFromCache = 0;
+    statEffectsQueued = 0;
+    statEffectsApplied = 0;
 }
 
 ItemReforge::~ItemReforge() {}
@@ -146,13 +332,17 @@ bool ItemReforge::GetEnabled() const
 
 void ItemReforge::SetReforgeableStats(const std::string& stats)
 {
+    ++configVersion;
     reforgeableStats.clear();
     std::vector<std::string_view> tokenized = Acore::Tokenize(stats, ',', false);
-    if (tokenized.size() <= MAX_REFORGEABLE_STATS)
+    if (tokenized.size() > MAX_REFORGEABLE_STATS)
     {
-        std::transform(tokenized.begin(), tokenized.end(), std::back_inserter(reforgeableStats),
-            [](const std::string_view& str) { return *Acore::StringTo<uint32>(str); });
+        LOG_WARN("module", "mod_reforging: ReforgeableStats lists {} stats, only the first {} are used", tokenized.size(), MAX_REFORGEABLE_STATS);
+        tokenized.resize(MAX_REFORGEABLE_STATS);
     }
+
+    std::transform(tokenized.begin(), tokenized.end(), std::back_inserter(reforgeableStats),
+        [](const std::string_view& str) { return *Acore::StringTo<uint32>(str); });
 }
 
 bool ItemReforge::IsReforgeableStat(uint32 stat) const
@@ -168,6 +358,7 @@ const std::vector<uint32>& ItemReforge::GetReforgeableStats() const
 
 void ItemReforge::SetPercentage(float value)
 {
+    ++configVersion;
     if (value < PERCENTAGE_MIN || value > PERCENTAGE_MAX)
         percentage = PERCENTAGE_DEFAULT;
     else
@@ -181,6 +372,7 @@ float ItemReforge::GetPercentage() const
 
 void ItemReforge::SetNeedMoney(uint32 value)
 {
+    ++configVersion;
     if (value < 0)
 		NeedMoney = NEEDMONEY_DEFAULT;
 	else
@@ -192,184 +384,92 @@ uint32 ItemReforge::GetNeedMoney() const
     return NeedMoney;
 }
 
-void ItemReforge::CleanupDB() const
+/*static*/ void ItemReforge::AppendSlotIcon(ReforgeTextWriter& writer, uint8 slot, uint32 width, uint32 height, int x, int y)
 {
-    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
-    CharacterDatabase.DirectExecute("DELETE FROM character_reforging WHERE guid NOT IN (SELECT guid FROM characters)");
-    CharacterDatabase.DirectExecute("DELETE FROM character_reforging WHERE item_guid NOT IN (SELECT guid FROM item_instance)");
-    CharacterDatabase.DirectCommitTransaction(trans);
+    writer.Append("|TInterface/PaperDoll/");
+    writer.Append(slot < EQUIPMENT_SLOT_END ? SLOT_ICONS[slot] : "UI-Backpack-EmptySlot");
+    writer.Append(':').AppendNumber(width).Append(':').AppendNumber(height).Append(':').AppendNumber(x).Append(':').AppendNumber(y).Append("|t");
 }
 
-void ItemReforge::LoadFromDB()
+std::string_view ItemReforge::GetSlotName(uint8 slot, LocaleConstant locale) const
 {
-    reforgingDataMap.clear();
+    if (slot >= EQUIPMENT_SLOT_END)
+        return UNKNOWN_STRING;
 
-    CleanupDB();
+    return slotNames[locale < TOTAL_LOCALES ? locale : LOCALE_enUS][slot];
+}
 
-    uint32 oldMSTime = getMSTime();
+std::string_view ItemReforge::StatTypeToString(uint32 statType, LocaleConstant locale) const
+{
+    if (statType >= MAX_STAT_NAMES)
+        return UNKNOWN_STRING;
 
-    QueryResult result = CharacterDatabase.Query("SELECT guid, item_guid, stat_decrease, stat_increase, stat_value FROM character_reforging");
-    if (!result)
-    {
-        LOG_INFO("server.loading", ">> Loaded 0 item reforges.");
-        LOG_INFO("server.loading", " ");
-        return;
-    }
+    return statNames[locale < TOTAL_LOCALES ? locale : LOCALE_enUS][statType];
+}
 
-    do
+void ItemReforge::FillDefaultStrings()
+{
+    for (uint8 locale = 0; locale < TOTAL_LOCALES; ++locale)
     {
-        Field* fields = result->Fetch();
+        statNames[locale].fill(UNKNOWN_STRING);
+        for (const StatName& statName : STAT_NAMES)
+            statNames[locale][statName.statType] = statName.name;
 
-        ReforgingData reforgingData;
-        reforgingData.guid = fields[0].Get<uint32>();
-        reforgingData.item_guid = fields[1].Get<uint32>();
-        reforgingData.stat_decrease = fields[2].Get<uint32>();
-        reforgingData.stat_increase = fields[3].Get<uint32>();
-        reforgingData.stat_value = fields[4].Get<uint32>();
-        reforgingDataMap[reforgingData.item_guid] = reforgingData;
-    } while (result->NextRow());
+        for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; ++slot)
+            slotNames[locale][slot] = SLOT_NAMES[slot];
+    }
 
-    LOG_INFO("server.loading", ">> Loaded {} item reforges in {} ms", reforgingDataMap.size(), GetMSTimeDiffToNow(oldMSTime));
-    LOG_INFO("server.loading", " ");
+    localizedStrings.clear();
 }
 
-std::string ItemReforge::GetSlotIcon(uint8 slot, uint32 width, uint32 height, int x, int y) const
+void ItemReforge::LoadStrings()
 {
-    std::ostringstream ss;
-    ss << "|TInterface/PaperDoll/";
-    switch (slot)
+    uint32 oldMSTime = getMSTime();
+
+    // 内置的中文名称作为所有语言的默认值, 表里有翻译的语言再覆盖
+    FillDefaultStrings();
+
+    QueryResult result = WorldDatabase.Query("SELECT `type`, `id`, `locale`, `text` FROM `mod_reforging_strings`");
+    if (!result)
     {
-        case EQUIPMENT_SLOT_HEAD:
-            ss << "UI-PaperDoll-Slot-Head";
-            break;
-        case EQUIPMENT_SLOT_NECK:
-            ss << "UI-PaperDoll-Slot-Neck";
-            break;
-        case EQUIPMENT_SLOT_SHOULDERS:
-            ss << "UI-PaperDoll-Slot-Shoulder";
-            break;
-        case EQUIPMENT_SLOT_BODY:
-            ss << "UI-PaperDoll-Slot-Shirt";
-            break;
-        case EQUIPMENT_SLOT_CHEST:
-            ss << "UI-PaperDoll-Slot-Chest";
-            break;
-        case EQUIPMENT_SLOT_WAIST:
-            ss << "UI-PaperDoll-Slot-Waist";
-            break;
-        case EQUIPMENT_SLOT_LEGS:
-            ss << "UI-PaperDoll-Slot-Legs";
-            break;
-        case EQUIPMENT_SLOT_FEET:
-            ss << "UI-PaperDoll-Slot-Feet";
-            break;
-        case EQUIPMENT_SLOT_WRISTS:
-            ss << "UI-PaperDoll-Slot-Wrists";
-            break;
-        case EQUIPMENT_SLOT_HANDS:
-            ss << "UI-PaperDoll-Slot-Hands";
-            break;
-        case EQUIPMENT_SLOT_FINGER1:
-        case EQUIPMENT_SLOT_FINGER2:
-            ss << "UI-PaperDoll-Slot-Finger";
-            break;
-        case EQUIPMENT_SLOT_TRINKET1:
-        case EQUIPMENT_SLOT_TRINKET2:
-            ss << "UI-PaperDoll-Slot-Trinket";
-            break;     
-        case EQUIPMENT_SLOT_BACK:
-            ss << "UI-PaperDoll-Slot-Chest";
-            break;
-        case EQUIPMENT_SLOT_MAINHAND:
-            ss << "UI-PaperDoll-Slot-MainHand";
-            break;
-        case EQUIPMENT_SLOT_OFFHAND:
-            ss << "UI-PaperDoll-Slot-SecondaryHand";
-            break;
-        case EQUIPMENT_SLOT_RANGED:
-            ss << "UI-PaperDoll-Slot-Ranged";
-            break;
-        case EQUIPMENT_SLOT_TABARD:
-            ss << "UI-PaperDoll-Slot-Tabard";
-            break;
-        default:
-            ss << "UI-Backpack-EmptySlot";
-            break;
+        LOG_INFO("server.loading", ">> Loaded 0 reforging strings. DB table `mod_reforging_strings` is empty.");
+        return;
     }
-    ss << ":" << width << ":" << height << ":" << x << ":" << y << "|t";
-    return ss.str();
-}
 
-std::string ItemReforge::GetSlotName(uint8 slot) const
-{
-    switch (slot)
+    uint32 count = 0;
+    do
     {
-        case EQUIPMENT_SLOT_HEAD:
-            return "头部";
-        case EQUIPMENT_SLOT_NECK:
-            return "颈部";
-        case EQUIPMENT_SLOT_SHOULDERS:
-            return "肩膀";
-        case EQUIPMENT_SLOT_BODY:
-            return "衬衣";
-        case EQUIPMENT_SLOT_CHEST:
-            return "胸部";
-        case EQUIPMENT_SLOT_WAIST:
-            return "腰部";
-        case EQUIPMENT_SLOT_LEGS:
-            return "腿部";
-        case EQUIPMENT_SLOT_FEET:
-            return "脚";
-        case EQUIPMENT_SLOT_WRISTS:
-            return "手腕";
-        case EQUIPMENT_SLOT_HANDS:
-            return "手";
-        case EQUIPMENT_SLOT_FINGER1:
-            return "手指一";
-        case EQUIPMENT_SLOT_FINGER2:
-            return "手指二";
-        case EQUIPMENT_SLOT_TRINKET1:
-            return "饰品一";
-        case EQUIPMENT_SLOT_TRINKET2:
-            return "饰品二";
-        case EQUIPMENT_SLOT_BACK:
-            return "披风";
-        case EQUIPMENT_SLOT_MAINHAND:
-            return "主手";
-        case EQUIPMENT_SLOT_OFFHAND:
-            return "副手";
-        case EQUIPMENT_SLOT_RANGED:
-            return "远程";
-        case EQUIPMENT_SLOT_TABARD:
-            return "战袍";
-        default:
-            return "未知";
-    }
-}
+        Field* fields = result->Fetch();
+        uint8 type = fields[0].Get<uint8>();
+        uint32 id = fields[1].Get<uint32>();
+        std::string localeName = fields[2].Get<std::string>();
 
-std::string ItemReforge::StatTypeToString(uint32 statType) const
-{
-    static std::unordered_map<uint32, std::string> statTypeToStrMap = {
-        {ITEM_MOD_MANA, "法力"}, {ITEM_MOD_HEALTH, "治疗"}, {ITEM_MOD_AGILITY, "敏捷"},
-        {ITEM_MOD_STRENGTH, "力量"}, {ITEM_MOD_INTELLECT, "智力"}, {ITEM_MOD_SPIRIT, "精神"},
-        {ITEM_MOD_STAMINA, "耐力"}, {ITEM_MOD_DEFENSE_SKILL_RATING, "防御"}, {ITEM_MOD_DODGE_RATING, "躲闪"},
-        {ITEM_MOD_PARRY_RATING, "招架"}, {ITEM_MOD_BLOCK_RATING, "格挡"}, {ITEM_MOD_HIT_MELEE_RATING, "近战命中"},
-        {ITEM_MOD_HIT_RANGED_RATING, "远程命中"}, {ITEM_MOD_HIT_SPELL_RATING, "技能命中"}, {ITEM_MOD_CRIT_MELEE_RATING, "近战暴击"},
-        {ITEM_MOD_CRIT_RANGED_RATING, "远程暴击"}, {ITEM_MOD_CRIT_SPELL_RATING, "法术暴击"}, {ITEM_MOD_HIT_TAKEN_MELEE_RATING, "近战被命中"},
-        {ITEM_MOD_HIT_TAKEN_RANGED_RATING, "远程被命中"}, {ITEM_MOD_HIT_TAKEN_SPELL_RATING, "法术被命中"}, {ITEM_MOD_CRIT_TAKEN_MELEE_RATING, "近战被暴击"},
-        {ITEM_MOD_CRIT_TAKEN_RANGED_RATING, "远程被暴击"}, {ITEM_MOD_CRIT_TAKEN_SPELL_RATING, "法术被暴击"}, {ITEM_MOD_HASTE_MELEE_RATING, "近战急速"},
-        {ITEM_MOD_HASTE_RANGED_RATING, "远程急速"}, {ITEM_MOD_HASTE_SPELL_RATING, "法术急速"}, {ITEM_MOD_HIT_RATING, "命中"},
-        {ITEM_MOD_CRIT_RATING, "暴击"}, {ITEM_MOD_HIT_TAKEN_RATING, "被命中"}, {ITEM_MOD_CRIT_TAKEN_RATING, "被暴击"},
-        {ITEM_MOD_RESILIENCE_RATING, "韧性"}, {ITEM_MOD_HASTE_RATING, "急速"}, {ITEM_MOD_EXPERTISE_RATING, "精准"},
-        {ITEM_MOD_ATTACK_POWER, "近战攻强"}, {ITEM_MOD_RANGED_ATTACK_POWER, "远程攻强"}, {ITEM_MOD_MANA_REGENERATION, "法力恢复"},
-        {ITEM_MOD_ARMOR_PENETRATION_RATING, "护甲穿透"}, {ITEM_MOD_SPELL_POWER, "法术强度"}, {ITEM_MOD_HEALTH_REGEN, "生命恢复"},
-        {ITEM_MOD_SPELL_PENETRATION, "法术穿透"}, {ITEM_MOD_BLOCK_VALUE, "格挡值"}
-    };
+        // GetLocaleByName 对未知名称返回 enUS, 拼错的语言不能覆盖 enUS 的名称
+        LocaleConstant locale = GetLocaleByName(localeName);
+        if (locale >= TOTAL_LOCALES || localeNames[locale] != localeName)
+        {
+            LOG_ERROR("sql.sql", "Table `mod_reforging_strings` has unknown locale '{}' for type {} / id {}, skipped.", localeName, type, id);
+            continue;
+        }
 
-    if (statTypeToStrMap.find(statType) != statTypeToStrMap.end())
-        return statTypeToStrMap.at(statType);
+        std::string_view* name = nullptr;
+        if (type == STRING_TYPE_STAT && id < MAX_STAT_NAMES)
+            name = &statNames[locale][id];
+        else if (type == STRING_TYPE_SLOT && id < EQUIPMENT_SLOT_END)
+            name = &slotNames[locale][id];
 
-    return "未知";
+        if (!name)
+        {
+            LOG_ERROR("sql.sql", "Table `mod_reforging_strings` has invalid type {} / id {}, skipped.", type, id);
+            continue;
+        }
+
+        localizedStrings.push_back(fields[3].Get<std::string>());
+        *name = localizedStrings.back();
+        ++count;
+    } while (result->NextRow());
+
+    LOG_INFO("server.loading", ">> Loaded {} reforging strings in {} ms", count, GetMSTimeDiffToNow(oldMSTime));
 }
 
 bool ItemReforge::IsReforgeable(const Player* player, const Item* item) const
@@ -406,7 +506,7 @@ bool ItemReforge::IsReforgeable(const Player* player, const Item* item) const
 
 bool ItemReforge::IsAlreadyReforged(const Item* item) const
 {
-    return reforgingDataMap.find(item->GetGUID().GetCounter()) != reforgingDataMap.end();
+    return sReforgeStore->Contains(item->GetGUID().GetCounter());
 }
 
 Item* ItemReforge::GetItemInSlot(const Player* player, uint8 slot) const
@@ -458,12 +558,14 @@ const _ItemStat* ItemReforge::FindItemStat(const std::vector<_ItemStat>& stats,
     return nullptr;
 }
 
-bool ItemReforge::Reforge(Player* player, ObjectGuid itemGuid, uint32 statDecrease, uint32 statIncrease)
+bool ItemReforge::MakeReforgingData(const Player* player, const Item* item, uint32 statDecrease, uint32 statIncrease, ReforgingData& reforgingData) const
 {
-    Item* item = player->GetItemByGuid(itemGuid);
     if (!IsReforgeable(player, item))
         return false;
 
+    if (!IsReforgeableStat(statDecrease) || !IsReforgeableStat(statIncrease))
+        return false;
+
     std::vector<_ItemStat> itemStats = LoadItemStatInfo(item);
     const _ItemStat* decreasedStat = FindItemStat(itemStats, statDecrease);
     if (decreasedStat == nullptr)
@@ -472,42 +574,204 @@ bool ItemReforge::Reforge(Player* player, ObjectGuid itemGuid, uint32 statDecrea
     if (FindItemStat(itemStats, statIncrease) != nullptr)
         return false;
 
-    if (!player->HasEnoughMoney(GetNeedMoney()))
-    {
-        ItemReforge::SendMessage(player, "你没有足够的钱重铸");
+    uint32 value = CalculateReforgePct(decreasedStat->ItemStatValue);
+    if (value == 0 || value > ReforgeFlatMap::MAX_STAT_VALUE || statIncrease > ReforgeFlatMap::MAX_STAT_TYPE)
         return false;
-	}
 
-    player->_ApplyItemMods(item, item->GetSlot(), false);
-
-    uint32 value = CalculateReforgePct(decreasedStat->ItemStatValue);
-    ReforgingData reforgingData;
     reforgingData.guid = player->GetGUID().GetCounter();
     reforgingData.item_guid = item->GetGUID().GetCounter();
     reforgingData.stat_decrease = statDecrease;
     reforgingData.stat_increase = statIncrease;
     reforgingData.stat_value = value;
-    reforgingDataMap[reforgingData.item_guid] = reforgingData;
+    return true;
+}
 
-    player->_ApplyItemMods(item, item->GetSlot(), true);
+bool ItemReforge::Reforge(Player* player, ObjectGuid itemGuid, uint32 statDecrease, uint32 statIncrease)
+{
+    Item* item = player->GetItemByGuid(itemGuid);
+    ReforgingData reforgingData;
+    if (!MakeReforgingData(player, item, statDecrease, statIncrease, reforgingData))
+        return false;
+
+    if (!player->HasEnoughMoney(GetNeedMoney()))
+    {
+        ItemReforge::SendMessage(player, "你没有足够的钱重铸");
+        return false;
+	}
+
+    if (!sReforgeStore->IsCharacterLoaded(player->GetGUID().GetCounter()))
+    {
+        ItemReforge::SendMessage(player, "重铸数据正在加载, 请稍后再试");
+        return false;
+    }
 
-    CharacterDatabase.Execute("INSERT INTO character_reforging (guid, item_guid, stat_decrease, stat_increase, stat_value) VALUES ({}, {}, {}, {}, {})",
-        reforgingData.guid, reforgingData.item_guid, statDecrease, statIncrease, value);
+    ChangeReforge(player, item, reforgingData);
 
     SendItemPacket(player, item);
     player->ModifyMoney(- GetNeedMoney());
     return true;
 }
 
-const ItemReforge::ReforgingData* ItemReforge::GetReforgingData(const Item* item) const
+bool ItemReforge::ReforgeBatch(Player* player, const std::vector<ReforgeChoice>& choices)
 {
-    if (!GetEnabled())
-        return nullptr;
+    if (choices.empty() || choices.size() > EQUIPMENT_SLOT_END)
+        return false;
 
-    if (IsAlreadyReforged(item))
-        return &reforgingDataMap.at(item->GetGUID().GetCounter());
+    if (!sReforgeStore->IsCharacterLoaded(player->GetGUID().GetCounter()))
+    {
+        ItemReforge::SendMessage(player, "重铸数据正在加载, 请稍后再试");
+        return false;
+    }
 
-    return nullptr;
+    // 先全部校验, 任何一项不合法都不做修改也不扣钱
+    std::vector<std::pair<Item*, ReforgingData>> reforges;
+    std::array<bool, EQUIPMENT_SLOT_END> usedSlots = {};
+    for (const ReforgeChoice& choice : choices)
+    {
+        if (choice.slot >= EQUIPMENT_SLOT_END || usedSlots[choice.slot])
+        {
+            ItemReforge::SendMessage(player, "批量重铸的槽位无效或重复");
+            return false;
+        }
+        usedSlots[choice.slot] = true;
+
+        Item* item = GetItemInSlot(player, choice.slot);
+        ReforgingData reforgingData;
+        if (!MakeReforgingData(player, item, choice.stat_decrease, choice.stat_increase, reforgingData))
+        {
+            ItemReforge::SendMessage(player, std::string(GetSlotName(choice.slot, player->GetSession()->GetSessionDbLocaleIndex())) + " 不能按指定属性重铸");
+            return false;
+        }
+
+        reforges.emplace_back(item, reforgingData);
+    }
+
+    uint64 cost = uint64(GetNeedMoney()) * reforges.size();
+    if (cost > MAX_MONEY_AMOUNT || !player->HasEnoughMoney(int32(cost)))
+    {
+        ItemReforge::SendMessage(player, "你没有足够的钱重铸");
+        return false;
+    }
+
+    // 属性变化在最后统一刷新, 数据库写入在同一个 tick 内进入写入队列, 由同一个事务提交
+    for (const std::pair<Item*, ReforgingData>& reforge : reforges)
+        ChangeReforge(player, reforge.first, reforge.second, false);
+    FlushStatModifiers(player);
+
+    for (const std::pair<Item*, ReforgingData>& reforge : reforges)
+        SendItemPacket(player, reforge.first);
+
+    player->ModifyMoney(-int32(cost));
+    return true;
+}
+
+float ItemReforge::SuggestReforges(Player* player, std::vector<ReforgeSuggestion>& suggestions) const
+{
+    static_assert(MAX_REFORGEABLE_STATS <= ReforgeOptimizer::MAX_STATS, "optimizer stat arrays are too small");
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    suggestions.clear();
+
+    // 属性按在可重铸属性列表里的位置编号, 有上限的属性从角色当前的战斗等级算起
+    uint32 statCount = std::min<uint32>(reforgeableStats.size(), MAX_REFORGEABLE_STATS);
+    ReforgeOptimizer optimizer(statCount);
+    for (uint32 i = 0; i < statCount; ++i)
+    {
+        uint32 stat = reforgeableStats[i];
+        if (stat >= MAX_STAT_NAMES)
+            continue;
+
+        int32 cap = int32(optimizerCaps[stat]);
+        int32 base = cap ? int32(player->GetUInt32Value(PLAYER_FIELD_COMBAT_RATING_1 + STAT_EFFECTS[stat].effects[0].target)) : 0;
+        optimizer.SetStat(i, optimizerWeights[stat], base, cap);
+    }
+
+    auto indexOf = [&](uint32 stat) -> int32
+    {
+        for (uint32 i = 0; i < statCount; ++i)
+            if (reforgeableStats[i] == stat)
+                return int32(i);
+        return -1;
+    };
+
+    // 候选项与 MakeReforgingData 的校验一致: 减少的属性在物品上, 增加的属性不在物品上
+    for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
+    {
+        Item* item = GetItemInSlot(player, slot);
+        if (!IsReforgeable(player, item))
+            continue;
+
+        ReforgeOptimizer::Slot slotOptions;
+        slotOptions.slot = slot;
+        std::vector<_ItemStat> itemStats = LoadItemStatInfo(item);
+        for (const _ItemStat& stat : itemStats)
+        {
+            int32 decrease = indexOf(stat.ItemStatType);
+            uint32 value = CalculateReforgePct(stat.ItemStatValue);
+            if (decrease < 0 || value == 0 || value > ReforgeFlatMap::MAX_STAT_VALUE)
+                continue;
+
+            for (uint32 increase = 0; increase < statCount; ++increase)
+            {
+                if (int32(increase) == decrease || reforgeableStats[increase] > ReforgeFlatMap::MAX_STAT_TYPE
+                    || FindItemStat(itemStats, reforgeableStats[increase]) != nullptr)
+                    continue;
+
+                slotOptions.options.push_back({ uint8(decrease), uint8(increase), int32(value) });
+            }
+        }
+
+        if (!slotOptions.options.empty())
+            optimizer.AddSlot(std::move(slotOptions));
+    }
+
+    float total = optimizer.Solve();
+    for (const ReforgeOptimizer::Slot& slot : optimizer.GetSlots())
+    {
+        if (slot.chosen < 0)
+            continue;
+
+        const ReforgeOptimizer::Option& option = slot.options[slot.chosen];
+        ReforgeSuggestion suggestion;
+        suggestion.slot = slot.slot;
+        suggestion.stat_decrease = reforgeableStats[option.decrease];
+        suggestion.stat_increase = reforgeableStats[option.increase];
+        suggestion.stat_value = uint32(option.value);
+        suggestions.push_back(suggestion);
+    }
+
+    uint32 elapsed = uint32(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+    ++optimizerRuns;
+    optimizerTime += elapsed;
+    // 多个地图线程可能同时更新最大值, 比较后再交换才不会被较小的值覆盖
+    uint32 previous = optimizerMaxTime;
+    while (elapsed > previous && !optimizerMaxTime.compare_exchange_weak(previous, elapsed))
+        ;
+
+    return total;
+}
+
+uint64 ItemReforge::GetOptimizerRuns() const
+{
+    return optimizerRuns;
+}
+
+uint64 ItemReforge::GetOptimizerTime() const
+{
+    return optimizerTime;
+}
+
+uint32 ItemReforge::GetOptimizerMaxTime() const
+{
+    return optimizerMaxTime;
+}
+
+std::optional<ItemReforge::ReforgingData> ItemReforge::GetReforgingData(const Item* item) const
+{
+    if (!GetEnabled())
+        return std::nullopt;
+
+    return sReforgeStore->Get(item->GetGUID().GetCounter());
 }
 
 std::vector<Item*> ItemReforge::GetPlayerItems(const Player* player, bool inBankAlso) const
@@ -561,21 +825,241 @@ bool ItemReforge::RemoveReforge(Player* player, Item* item)
     if (!item || !IsAlreadyReforged(item))
         return false;
 
+    ChangeReforge(player, item, std::nullopt);
+    SendItemPacket(player, item);
+
+    return true;
+}
+
+ItemReforge::GossipSelection::GossipSelection()
+{
+    ++sItemReforge->gossipSelections;
+}
+
+ItemReforge::GossipSelection::~GossipSelection()
+{
+    --sItemReforge->gossipSelections;
+}
+
+void ItemReforge::SetGossipSelection(Player* player, ObjectGuid itemGuid)
+{
+    GossipSelection* selection = player->CustomData.GetDefault<GossipSelection>(GOSSIP_SELECTION_KEY);
+    selection->itemGuid = itemGuid;
+    selection->selectTime = getMSTime();
+}
+
+ObjectGuid ItemReforge::GetGossipSelection(Player* player) const
+{
+    GossipSelection* selection = player->CustomData.Get<GossipSelection>(GOSSIP_SELECTION_KEY);
+    if (!selection)
+        return ObjectGuid::Empty;
+
+    // 打开菜单后长时间没有操作, 按没有选择处理
+    if (GetMSTimeDiffToNow(selection->selectTime) > GOSSIP_SELECTION_TIMEOUT_MS)
+    {
+        ClearGossipSelection(player);
+        return ObjectGuid::Empty;
+    }
+
+    return selection->itemGuid;
+}
+
+void ItemReforge::ClearGossipSelection(Player* player) const
+{
+    player->CustomData.Erase(GOSSIP_SELECTION_KEY);
+}
+
+uint32 ItemReforge::GetGossipSelectionCount() const
+{
+    return gossipSelections;
+}
+
+uint32 ItemReforge::GetGearVersion(Player* player) const
+{
+    return GetPlayerState(player)->gearVersion;
+}
+
+uint32 ItemReforge::GetConfigVersion() const
+{
+    return configVersion;
+}
+
+void ItemReforge::CountMenuBuild(bool cached)
+{
+    if (cached)
+        ++menusFromCache;
+    else
+        ++menusBuilt;
+}
+
+uint64 ItemReforge::GetMenusBuilt() const
+{
+    return menusBuilt;
+}
+
+uint64 ItemReforge::GetMenusFromCache() const
+{
+    return menusFromCache;
+}
+
+bool ItemReforge::CanApplyDifferential(const Item* item) const
+{
+    // 损坏的物品没有应用属性; 按等级缩放的物品属性来自 ScalingStatDistribution, 走完整重算
+    if (!item->IsEquipped() || item->IsBroken())
+        return false;
+
+    return item->GetTemplate()->ScalingStatDistribution == 0;
+}
+
+void ItemReforge::ChangeReforge(Player* player, Item* item, const std::optional<ReforgingData>& reforgingData, bool flush)
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
     bool equipped = item->IsEquipped();
+    bool differential = CanApplyDifferential(item);
 
-    if (equipped)
+    // 差量更新: 只撤销旧重铸并应用新重铸, 不重新计算护甲/伤害/装备法术等
+    EquippedReforge applied;
+    if (differential)
+    {
+        if (GetEquippedReforge(player, item->GetSlot(), applied))
+        {
+            HandleStatModifier(player, applied.stat_decrease, applied.stat_value, true);
+            HandleStatModifier(player, applied.stat_increase, applied.stat_value, false);
+        }
+    }
+    else if (equipped)
         player->_ApplyItemMods(item, item->GetSlot(), false);
 
-    reforgingDataMap.erase(item->GetGUID().GetCounter());
+    if (reforgingData)
+        sReforgeStore->Set(*reforgingData);
+    else
+        sReforgeStore->Remove(item->GetGUID().GetCounter(), player->GetGUID().GetCounter());
+    InvalidateEquippedReforge(player, item);
 
-    if (equipped)
+    if (differential)
+    {
+        if (GetEquippedReforge(player, item->GetSlot(), applied))
+        {
+            HandleStatModifier(player, applied.stat_decrease, applied.stat_value, false);
+            HandleStatModifier(player, applied.stat_increase, applied.stat_value, true);
+        }
+    }
+    else if (equipped)
         player->_ApplyItemMods(item, item->GetSlot(), true);
-    
-    CharacterDatabase.Execute("DELETE FROM character_reforging WHERE item_guid = {}", item->GetGUID().GetCounter());
 
-    SendItemPacket(player, item);
+    if (flush)
+        FlushStatModifiers(player);
 
-    return true;
+    uint64 elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    if (differential)
+    {
+        ++differentialApplies;
+        differentialApplyTime += elapsed;
+        if (verifyDifferential && flush)
+            VerifyDifferential(player, item);
+    }
+    else if (equipped)
+    {
+        ++fullApplies;
+        fullApplyTime += elapsed;
+    }
+}
+
+void ItemReforge::VerifyDifferential(Player* player, Item* item) const
+{
+    std::vector<uint32> values(PLAYER_END);
+    for (uint16 i = 0; i < PLAYER_END; ++i)
+        values[i] = player->GetUInt32Value(i);
+
+    player->_ApplyItemMods(item, item->GetSlot(), false);
+    player->_ApplyItemMods(item, item->GetSlot(), true);
+    FlushStatModifiers(player);
+
+    // 完整重算时当前生命值和能量会被上限截断, 不参与比较
+    uint32 mismatches = 0;
+    uint16 firstMismatch = 0;
+    for (uint16 i = 0; i < PLAYER_END; ++i)
+    {
+        if (i == UNIT_FIELD_HEALTH || (i >= UNIT_FIELD_POWER1 && i <= UNIT_FIELD_POWER7))
+            continue;
+
+        if (values[i] != player->GetUInt32Value(i) && mismatches++ == 0)
+            firstMismatch = i;
+    }
+
+    if (mismatches)
+    {
+        ++differentialMismatches;
+        LOG_ERROR("module", "mod_reforging: differential reforge update for item {} of player {} differs from a full reapply in {} fields (first field {})",
+            item->GetEntry(), player->GetName(), mismatches, firstMismatch);
+    }
+}
+
+void ItemReforge::SetVerifyDifferential(bool value)
+{
+    verifyDifferential = value;
+}
+
+uint64 ItemReforge::GetDifferentialApplies() const
+{
+    return differentialApplies;
+}
+
+uint64 ItemReforge::GetDifferentialApplyTime() const
+{
+    return differentialApplyTime;
+}
+
+uint64 ItemReforge::GetFullApplies() const
+{
+    return fullApplies;
+}
+
+uint64 ItemReforge::GetFullApplyTime() const
+{
+    return fullApplyTime;
+}
+
+uint64 ItemReforge::GetDifferentialMismatches() const
+{
+    return differentialMismatches;
+}
+
+void ItemReforge::SetOptimizerWeights(const std::string& weights)
+{
+    optimizerWeights.fill(0.0f);
+    for (std::string_view entry : Acore::Tokenize(weights, ',', false))
+    {
+        std::vector<std::string_view> fields = Acore::Tokenize(entry, ':', false);
+        Optional<uint32> stat = fields.size() == 2 ? Acore::StringTo<uint32>(fields[0]) : std::nullopt;
+        Optional<float> weight = fields.size() == 2 ? Acore::StringTo<float>(fields[1]) : std::nullopt;
+        if (!stat || !weight || *stat >= MAX_STAT_NAMES)
+        {
+            LOG_ERROR("module", "mod_reforging: invalid entry '{}' in Reforging.Optimizer.Weights, skipped", entry);
+            continue;
+        }
+
+        optimizerWeights[*stat] = *weight;
+    }
+}
+
+void ItemReforge::SetOptimizerCaps(const std::string& caps)
+{
+    optimizerCaps.fill(0);
+    for (std::string_view entry : Acore::Tokenize(caps, ',', false))
+    {
+        std::vector<std::string_view> fields = Acore::Tokenize(entry, ':', false);
+        Optional<uint32> stat = fields.size() == 2 ? Acore::StringTo<uint32>(fields[0]) : std::nullopt;
+        Optional<uint32> cap = fields.size() == 2 ? Acore::StringTo<uint32>(fields[1]) : std::nullopt;
+        // 上限按角色当前的战斗等级计算, 只能用于等级类属性
+        if (!stat || !cap || *stat >= MAX_STAT_NAMES || STAT_EFFECTS[*stat].effects[0].type != StatEffectType::RATING)
+        {
+            LOG_ERROR("module", "mod_reforging: invalid entry '{}' in Reforging.Optimizer.Caps, skipped", entry);
+            continue;
+        }
+
+        optimizerCaps[*stat] = *cap;
+    }
 }
 
 void ItemReforge::VisualFeedback(Player* player)
@@ -583,178 +1067,125 @@ void ItemReforge::VisualFeedback(Player* player)
     player->CastSpell(player, VISUAL_FEEDBACK_SPELL_ID, true);
 }
 
-void ItemReforge::HandleCharacterRemove(uint32 guid)
+void ItemReforge::HandleStatModifier(Player* player, uint32 statType, int32 val, bool apply)
 {
-    for (auto it = reforgingDataMap.begin(); it != reforgingDataMap.end(); )
+    if (val == 0 || statType >= STAT_EFFECTS.size())
+        return;
+
+    const StatEffects& effects = STAT_EFFECTS[statType];
+
+    // 载入和下线时不在世界中, 之后的计算(如按上限截断生命值)依赖属性已经生效, 直接应用
+    if (!player->IsInWorld())
     {
-        if (it->second.guid == guid)
-            it = reforgingDataMap.erase(it);
+        for (uint8 i = 0; i < effects.count; ++i)
+            ApplyStatEffect(player, effects.effects[i], val, apply);
+        return;
+    }
+
+    // 同一个 tick 里的变化按效果合并, 每个等级/属性只在刷新时重算一次
+    ReforgePlayerState* state = GetPlayerState(player);
+    int32 delta = apply ? val : -val;
+    for (uint8 i = 0; i < effects.count; ++i)
+    {
+        uint16 key = (uint16(effects.effects[i].type) << 8) | effects.effects[i].target;
+        ReforgePlayerState::PendingEffectContainer::iterator itr = std::find_if(state->pendingEffects.begin(), state->pendingEffects.end(),
+            [key](const std::pair<uint16, int32>& pending) { return pending.first == key; });
+        if (itr != state->pendingEffects.end())
+            itr->second += delta;
         else
-            ++it;
+            state->pendingEffects.emplace_back(key, delta);
     }
+
+    statEffectsQueued += effects.count;
 }
 
-void ItemReforge::HandleStatModifier(Player* player, uint32 statType, int32 val, bool apply)
+void ItemReforge::FlushStatModifiers(Player* player) const
 {
-    if (val == 0)
+    ReforgePlayerState* state = player->CustomData.Get<ReforgePlayerState>(PLAYER_STATE_KEY);
+    if (!state || state->pendingEffects.empty())
         return;
 
-    switch (statType)
+    for (const std::pair<uint16, int32>& pending : state->pendingEffects)
     {
-        case ITEM_MOD_MANA:
-            player->HandleStatModifier(UNIT_MOD_MANA, BASE_VALUE, float(val), apply);
-            break;
-        case ITEM_MOD_HEALTH:                           // modify HP
-            player->HandleStatModifier(UNIT_MOD_HEALTH, BASE_VALUE, float(val), apply);
-            break;
-        case ITEM_MOD_AGILITY:                          // modify agility
-            player->HandleStatModifier(UNIT_MOD_STAT_AGILITY, BASE_VALUE, float(val), apply);
-            player->ApplyStatBuffMod(STAT_AGILITY, float(val), apply);
-            break;
-        case ITEM_MOD_STRENGTH:                         //modify strength
-            player->HandleStatModifier(UNIT_MOD_STAT_STRENGTH, BASE_VALUE, float(val), apply);
-            player->ApplyStatBuffMod(STAT_STRENGTH, float(val), apply);
-            break;
-        case ITEM_MOD_INTELLECT:                        //modify intellect
-            player->HandleStatModifier(UNIT_MOD_STAT_INTELLECT, BASE_VALUE, float(val), apply);
-            player->ApplyStatBuffMod(STAT_INTELLECT, float(val), apply);
-            break;
-        case ITEM_MOD_SPIRIT:                           //modify spirit
-            player->HandleStatModifier(UNIT_MOD_STAT_SPIRIT, BASE_VALUE, float(val), apply);
-            player->ApplyStatBuffMod(STAT_SPIRIT, float(val), apply);
-            break;
-        case ITEM_MOD_STAMINA:                          //modify stamina
-            player->HandleStatModifier(UNIT_MOD_STAT_STAMINA, BASE_VALUE, float(val), apply);
-            player->ApplyStatBuffMod(STAT_STAMINA, float(val), apply);
-            break;
-        case ITEM_MOD_DEFENSE_SKILL_RATING:
-            player->ApplyRatingMod(CR_DEFENSE_SKILL, int32(val), apply);
-            break;
-        case ITEM_MOD_DODGE_RATING:
-            player->ApplyRatingMod(CR_DODGE, int32(val), apply);
-            break;
-        case ITEM_MOD_PARRY_RATING:
-            player->ApplyRatingMod(CR_PARRY, int32(val), apply);
-            break;
-        case ITEM_MOD_BLOCK_RATING:
-            player->ApplyRatingMod(CR_BLOCK, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_MELEE_RATING:
-            player->ApplyRatingMod(CR_HIT_MELEE, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_RANGED_RATING:
-            player->ApplyRatingMod(CR_HIT_RANGED, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_SPELL_RATING:
-            player->ApplyRatingMod(CR_HIT_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_MELEE_RATING:
-            player->ApplyRatingMod(CR_CRIT_MELEE, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_RANGED_RATING:
-            player->ApplyRatingMod(CR_CRIT_RANGED, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_SPELL_RATING:
-            player->ApplyRatingMod(CR_CRIT_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_TAKEN_MELEE_RATING:
-            player->ApplyRatingMod(CR_HIT_TAKEN_MELEE, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_TAKEN_RANGED_RATING:
-            player->ApplyRatingMod(CR_HIT_TAKEN_RANGED, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_TAKEN_SPELL_RATING:
-            player->ApplyRatingMod(CR_HIT_TAKEN_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_TAKEN_MELEE_RATING:
-            player->ApplyRatingMod(CR_CRIT_TAKEN_MELEE, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_TAKEN_RANGED_RATING:
-            player->ApplyRatingMod(CR_CRIT_TAKEN_RANGED, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_TAKEN_SPELL_RATING:
-            player->ApplyRatingMod(CR_CRIT_TAKEN_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_HASTE_MELEE_RATING:
-            player->ApplyRatingMod(CR_HASTE_MELEE, int32(val), apply);
-            break;
-        case ITEM_MOD_HASTE_RANGED_RATING:
-            player->ApplyRatingMod(CR_HASTE_RANGED, int32(val), apply);
-            break;
-        case ITEM_MOD_HASTE_SPELL_RATING:
-            player->ApplyRatingMod(CR_HASTE_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_RATING:
-            player->ApplyRatingMod(CR_HIT_MELEE, int32(val), apply);
-            player->ApplyRatingMod(CR_HIT_RANGED, int32(val), apply);
-            player->ApplyRatingMod(CR_HIT_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_RATING:
-            player->ApplyRatingMod(CR_CRIT_MELEE, int32(val), apply);
-            player->ApplyRatingMod(CR_CRIT_RANGED, int32(val), apply);
-            player->ApplyRatingMod(CR_CRIT_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_HIT_TAKEN_RATING:
-            player->ApplyRatingMod(CR_HIT_TAKEN_MELEE, int32(val), apply);
-            player->ApplyRatingMod(CR_HIT_TAKEN_RANGED, int32(val), apply);
-            player->ApplyRatingMod(CR_HIT_TAKEN_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_CRIT_TAKEN_RATING:
-        case ITEM_MOD_RESILIENCE_RATING:
-            player->ApplyRatingMod(CR_CRIT_TAKEN_MELEE, int32(val), apply);
-            player->ApplyRatingMod(CR_CRIT_TAKEN_RANGED, int32(val), apply);
-            player->ApplyRatingMod(CR_CRIT_TAKEN_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_HASTE_RATING:
-            player->ApplyRatingMod(CR_HASTE_MELEE, int32(val), apply);
-            player->ApplyRatingMod(CR_HASTE_RANGED, int32(val), apply);
-            player->ApplyRatingMod(CR_HASTE_SPELL, int32(val), apply);
-            break;
-        case ITEM_MOD_EXPERTISE_RATING:
-            player->ApplyRatingMod(CR_EXPERTISE, int32(val), apply);
-            break;
-        case ITEM_MOD_ATTACK_POWER:
-            player->HandleStatModifier(UNIT_MOD_ATTACK_POWER, TOTAL_VALUE, float(val), apply);
-            player->HandleStatModifier(UNIT_MOD_ATTACK_POWER_RANGED, TOTAL_VALUE, float(val), apply);
-            break;
-        case ITEM_MOD_RANGED_ATTACK_POWER:
-            player->HandleStatModifier(UNIT_MOD_ATTACK_POWER_RANGED, TOTAL_VALUE, float(val), apply);
-            break;
-            //            case ITEM_MOD_FERAL_ATTACK_POWER:
-            //                ApplyFeralAPBonus(int32(val), apply);
-            //                break;
-        case ITEM_MOD_MANA_REGENERATION:
-            player->ApplyManaRegenBonus(int32(val), apply);
-            break;
-        case ITEM_MOD_ARMOR_PENETRATION_RATING:
-            player->ApplyRatingMod(CR_ARMOR_PENETRATION, int32(val), apply);
-            break;
-        case ITEM_MOD_SPELL_POWER:
-            player->ApplySpellPowerBonus(int32(val), apply);
-            break;
-        case ITEM_MOD_HEALTH_REGEN:
-            player->ApplyHealthRegenBonus(int32(val), apply);
-            break;
-        case ITEM_MOD_SPELL_PENETRATION:
-            player->ApplySpellPenetrationBonus(val, apply);
-            break;
-        case ITEM_MOD_BLOCK_VALUE:
-            player->HandleBaseModValue(SHIELD_BLOCK_VALUE, FLAT_MOD, float(val), apply);
-            break;
-            /// @deprecated item mods
-        case ITEM_MOD_SPELL_HEALING_DONE:
-        case ITEM_MOD_SPELL_DAMAGE_DONE:
-            break;
+        // 卸下再穿上同一件装备时变化互相抵消, 不需要重算
+        if (pending.second == 0)
+            continue;
+
+        StatEffect effect = { StatEffectType(pending.first >> 8), uint8(pending.first & 0xFF) };
+        ApplyStatEffect(player, effect, std::abs(pending.second), pending.second > 0);
+        ++statEffectsApplied;
     }
+
+    state->pendingEffects.clear();
+}
+
+uint64 ItemReforge::GetStatEffectsQueued() const
+{
+    return statEffectsQueued;
+}
+
+uint64 ItemReforge::GetStatEffectsApplied() const
+{
+    return statEffectsApplied;
+}
+
+ItemReforge::ItemPacketKey ItemReforge::MakeItemPacketKey(const Player* player, const Item* item, const std::optional<ReforgingData>& reforgingData) const
+{
+    ItemPacketKey key;
+    key.entry = item->GetEntry();
+    key.stat_value = reforgingData ? uint16(reforgingData->stat_value) : 0;
+    key.locale = uint8(player->GetSession()->GetSessionDbLocaleIndex());
+    key.stat_decrease = reforgingData ? uint8(reforgingData->stat_decrease) : 0;
+    key.stat_increase = reforgingData ? uint8(reforgingData->stat_increase) : 0;
+    return key;
 }
 
 void ItemReforge::SendItemPacket(Player* player, const Item* item) const
 {
-    ItemTemplate const* pProto = sObjectMgr->GetItemTemplate(item->GetEntry());
+    std::optional<ReforgingData> reforgingData = GetReforgingData(item);
+    SendItemPacket(player, MakeItemPacketKey(player, item, reforgingData), reforgingData);
+}
+
+void ItemReforge::SendItemPacket(Player* player, const ItemPacketKey& key, const std::optional<ReforgingData>& reforgingData) const
+{
+    ItemTemplate const* proto = sObjectMgr->GetItemTemplate(key.entry);
+    if (!proto)
+        return;
+
+    std::shared_ptr<WorldPacket const> packet;
+    {
+        std::shared_lock<std::shared_mutex> guard(itemPacketLock);
+        ItemPacketContainer::const_iterator itr = itemPackets.find(key);
+        if (itr != itemPackets.end())
+            packet = itr->second;
+    }
+
+    if (packet)
+        ++itemPacketsFromCache;
+    else
+    {
+        packet = BuildItemPacket(proto, player->GetSession()->GetSessionDbLocaleIndex(), reforgingData);
+        ++itemPacketsBuilt;
+
+        std::unique_lock<std::shared_mutex> guard(itemPacketLock);
+        // 组合数超出上限时整体清空, 热门物品很快会重新缓存
+        if (itemPackets.size() >= MAX_ITEM_PACKETS)
+            itemPackets.clear();
+        itemPackets.emplace(key, packet);
+    }
+
+    player->GetSession()->SendPacket(packet.get());
+
+    // 客户端按物品模板缓存查询结果, 记录本次会话里每个模板最后发送的内容
+    SentItemPackets* sent = player->CustomData.GetDefault<SentItemPackets>(SENT_ITEM_PACKETS_KEY);
+    sent->entries[key.entry] = key;
+}
+
+std::shared_ptr<WorldPacket const> ItemReforge::BuildItemPacket(ItemTemplate const* pProto, int loc_idx, const std::optional<ReforgingData>& reforgingData) const
+{
     std::string Name = pProto->Name1;
     std::string Description = pProto->Description;
 
-    int loc_idx = player->GetSession()->GetSessionDbLocaleIndex();
     if (loc_idx >= 0)
     {
         if (ItemLocale const* il = sObjectMgr->GetItemLocale(pProto->ItemId))
@@ -763,8 +1194,9 @@ void ItemReforge::SendItemPacket(Player* player, const Item* item) const
             ObjectMgr::GetLocaleString(il->Description, loc_idx, Description);
         }
     }
-    // guess size
-    WorldPacket queryData(SMSG_ITEM_QUERY_SINGLE_RESPONSE, 600);
+    // 每个线程复用一块组包缓冲区, 最后按实际大小复制到缓存的包里
+    thread_local ByteBuffer queryData(600);
+    queryData.clear();
     queryData << pProto->ItemId;
     queryData << pProto->Class;
     queryData << pProto->SubClass;
@@ -794,8 +1226,7 @@ void ItemReforge::SendItemPacket(Player* player, const Item* item) const
     queryData << int32(pProto->MaxCount);
     queryData << int32(pProto->Stackable);
     queryData << pProto->ContainerSlots;
-    const ReforgingData* reforgingData = GetReforgingData(item);
-    if (reforgingData == nullptr)
+    if (!reforgingData)
     {
         queryData << pProto->StatsCount;
         for (uint32 i = 0; i < pProto->StatsCount; ++i)
@@ -909,86 +1340,276 @@ void ItemReforge::SendItemPacket(Player* player, const Item* item) const
     queryData << pProto->Duration;                           // added in 2.4.2.8209, duration (seconds)
     queryData << pProto->ItemLimitCategory;                  // WotLK, ItemLimitCategory
     queryData << pProto->HolidayId;                          // Holiday.dbc?
-    player->GetSession()->SendPacket(&queryData);
+
+    // 缓存的包会一直保留, 按实际大小复制一份, 不保留猜测的容量
+    std::shared_ptr<WorldPacket> packet = std::make_shared<WorldPacket>(SMSG_ITEM_QUERY_SINGLE_RESPONSE, queryData.size());
+    packet->append(queryData);
+    return packet;
+}
+
+void ItemReforge::ClearItemPacketCache()
+{
+    std::unique_lock<std::shared_mutex> guard(itemPacketLock);
+    itemPackets.clear();
+}
+
+uint32 ItemReforge::GetItemPacketCacheSize() const
+{
+    std::shared_lock<std::shared_mutex> guard(itemPacketLock);
+    return itemPackets.size();
 }
 
-void ItemReforge::SendItemPackets(Player* player) const
+uint64 ItemReforge::GetItemPacketsBuilt() const
 {
+    return itemPacketsBuilt;
+}
+
+uint64 ItemReforge::GetItemPacketsFromCache() const
+{
+    return itemPacketsFromCache;
+}
+
+uint32 ItemReforge::SendReforgedItemPackets(Player* player) const
+{
+    uint32 count = 0;
+    SentItemPackets* sent = player->CustomData.GetDefault<SentItemPackets>(SENT_ITEM_PACKETS_KEY);
     std::vector<Item*> items = GetPlayerItems(player, true);
     std::vector<Item*>::const_iterator itr = items.begin();
     for (/* itr */; itr != items.end(); ++itr)
-        SendItemPacket(player, *itr);
+    {
+        // 未重铸的物品客户端自己查询模板即可
+        std::optional<ReforgingData> reforgingData = GetReforgingData(*itr);
+        if (!reforgingData)
+            continue;
+
+        // 同一模板的多个物品, 或本次会话已经发送过相同内容的模板不再重复发送
+        ItemPacketKey key = MakeItemPacketKey(player, *itr, reforgingData);
+        SentItemPackets::EntryContainer::const_iterator sentItr = sent->entries.find(key.entry);
+        if (sentItr != sent->entries.end() && sentItr->second == key)
+        {
+            ++itemPacketsSkipped;
+            continue;
+        }
+
+        SendItemPacket(player, key, reforgingData);
+        ++count;
+    }
+
+    return count;
 }
 
-void ItemReforge::HandleReload(Player* player, bool apply) const
+uint64 ItemReforge::GetItemPacketsSkipped() const
 {
-    std::vector<Item*> playerItems = GetPlayerItems(player, true);
-    std::vector<Item*>::iterator iter = playerItems.begin();
-    for (/* itr */; iter != playerItems.end(); ++iter)
-    {
-        Item* item = *iter;
-        if (apply)
-            SendItemPacket(player, item);
+    return itemPacketsSkipped;
+}
 
-        if (!item->IsEquipped())
+uint32 ItemReforge::ResetReforgedItemPackets(Player* player) const
+{
+    SentItemPackets* sent = player->CustomData.GetDefault<SentItemPackets>(SENT_ITEM_PACKETS_KEY);
+    std::vector<ItemPacketKey> keys;
+    SentItemPackets::EntryContainer::const_iterator itr = sent->entries.begin();
+    for (/* itr */; itr != sent->entries.end(); ++itr)
+    {
+        if (itr->second.stat_increase == 0)
             continue;
 
-        player->_ApplyItemMods(item, item->GetSlot(), apply);
+        ItemPacketKey key = itr->second;
+        key.stat_value = 0;
+        key.stat_decrease = 0;
+        key.stat_increase = 0;
+        keys.push_back(key);
     }
+
+    for (const ItemPacketKey& key : keys)
+        SendItemPacket(player, key, std::nullopt);
+
+    return keys.size();
 }
 
-void ItemReforge::HandleReload(bool apply) const
+ItemReforge::ReforgePlayerState* ItemReforge::GetPlayerState(Player* player) const
 {
-    const WorldSessionMgr::SessionMap& sessions = sWorldSessionMgr->GetAllSessions();
-    WorldSessionMgr::SessionMap::const_iterator itr;
-    for (itr = sessions.begin(); itr != sessions.end(); ++itr)
-        if (itr->second && itr->second->GetPlayer() && itr->second->GetPlayer()->IsInWorld())
-            HandleReload(itr->second->GetPlayer(), apply);
+    // 第一次应用物品属性时记录当时的开关, 之后只有重载任务会修改
+    ReforgePlayerState* state = player->CustomData.Get<ReforgePlayerState>(PLAYER_STATE_KEY);
+    if (!state)
+    {
+        state = player->CustomData.GetDefault<ReforgePlayerState>(PLAYER_STATE_KEY);
+        state->applied = GetEnabled();
+    }
+
+    return state;
 }
 
-/*static*/ void ItemReforge::SendMessage(Player* player, const std::string& message)
+bool ItemReforge::AreReforgesApplied(Player* player) const
 {
-    ChatHandler(player->GetSession()).SendSysMessage(message);
+    return GetPlayerState(player)->applied;
+}
+
+bool ItemReforge::GetEquippedReforge(Player* player, uint8 slot, EquippedReforge& reforge) const
+{
+    Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot);
+    if (!item)
+        return false;
+
+    // 同一件物品的每条属性都会调用一次, 线程内记住上一次的结果
+    struct LastEquippedReforge
+    {
+        uint32 player;
+        uint32 epoch;
+        EquippedReforge reforge;
+    };
+    static thread_local LastEquippedReforge last = {};
+
+    uint32 itemGuid = item->GetGUID().GetCounter();
+    uint32 playerGuid = player->GetGUID().GetCounter();
+    uint32 epoch = equippedReforgeEpoch;
+    if (last.reforge.item_guid != itemGuid || last.player != playerGuid || last.epoch != epoch)
+    {
+        ReforgePlayerState* state = GetPlayerState(player);
+        EquippedReforge* entry = slot < state->slots.size() ? &state->slots[slot] : nullptr;
+        if (!entry || entry->item_guid != itemGuid)
+        {
+            EquippedReforge resolved = {};
+            resolved.item_guid = itemGuid;
+            resolved.stats_count = item->GetTemplate()->StatsCount;
+            if (std::optional<ReforgingData> reforgingData = state->applied ? sReforgeStore->Get(itemGuid) : std::nullopt)
+            {
+                resolved.stat_value = reforgingData->stat_value;
+                resolved.stat_decrease = reforgingData->stat_decrease;
+                resolved.stat_increase = reforgingData->stat_increase;
+                resolved.reforged = true;
+            }
+
+            if (entry)
+                *entry = resolved;
+            last.reforge = resolved;
+        }
+        else
+            last.reforge = *entry;
+
+        last.player = playerGuid;
+        last.epoch = epoch;
+    }
+
+    reforge = last.reforge;
+    return reforge.reforged;
+}
+
+void ItemReforge::InvalidateEquippedReforge(Player* player, const Item* item) const
+{
+    if (ReforgePlayerState* state = player->CustomData.Get<ReforgePlayerState>(PLAYER_STATE_KEY))
+    {
+        ++state->gearVersion;
+        if (item->GetBagSlot() == INVENTORY_SLOT_BAG_0 && item->GetSlot() < state->slots.size())
+            state->slots[item->GetSlot()].item_guid = 0;
+    }
+
+    ++equippedReforgeEpoch;
+}
+
+uint32 ItemReforge::BenchmarkReapply(Player* player, uint32 iterations, bool resolve) const
+{
+    std::vector<Item*> equipped;
+    for (uint8 i = EQUIPMENT_SLOT_START; i < EQUIPMENT_SLOT_END; i++)
+        if (Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i))
+            equipped.push_back(item);
+
+    // resolve 为真时每轮都丢弃栏位表, 与每条属性都查询存储的旧做法比较
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (uint32 i = 0; i < iterations; ++i)
+    {
+        if (resolve)
+            for (Item* item : equipped)
+                InvalidateEquippedReforge(player, item);
+
+        for (Item* item : equipped)
+            player->_ApplyItemMods(item, item->GetSlot(), false);
+
+        for (Item* item : equipped)
+            player->_ApplyItemMods(item, item->GetSlot(), true);
+
+        FlushStatModifiers(player);
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool ItemReforge::ReloadPlayer(Player* player) const
+{
+    // 还没有应用过物品属性的角色会直接按当前开关应用
+    ReforgePlayerState* state = player->CustomData.Get<ReforgePlayerState>(PLAYER_STATE_KEY);
+    if (!state || state->applied == GetEnabled())
+        return false;
+
+    std::vector<Item*> equipped;
+    for (uint8 i = EQUIPMENT_SLOT_START; i < EQUIPMENT_SLOT_END; i++)
+        if (Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, i))
+            equipped.push_back(item);
+
+    for (Item* item : equipped)
+        player->_ApplyItemMods(item, item->GetSlot(), false);
+
+    state->applied = GetEnabled();
+    state->slots.fill(EquippedReforge());
+    ++state->gearVersion;
+    ++equippedReforgeEpoch;
+
+    for (Item* item : equipped)
+        player->_ApplyItemMods(item, item->GetSlot(), true);
+
+    FlushStatModifiers(player);
+
+    if (state->applied)
+        SendReforgedItemPackets(player);
+    else
+        ResetReforgedItemPackets(player);
+
+    return true;
 }
 
-/*static*/ std::string ItemReforge::TextWithColor(const std::string& text, const std::string& color)
+/*static*/ void ItemReforge::SendMessage(Player* player, const std::string& message)
 {
-    return "|cff" + color + text + "|r";
+    ChatHandler(player->GetSession()).SendSysMessage(message);
 }
 
-/*static*/ std::string ItemReforge::TextRed(const std::string& text)
+/*static*/ void ItemReforge::AppendRed(ReforgeTextWriter& writer, std::string_view text)
 {
-    return TextWithColor(text, RED_COLOR);
+    writer.AppendColored(text, RED_COLOR);
 }
 
-/*static*/ std::string ItemReforge::TextGreen(const std::string& text)
+/*static*/ void ItemReforge::AppendGreen(ReforgeTextWriter& writer, std::string_view text)
 {
-    return TextWithColor(text, GREEN_COLOR);
+    writer.AppendColored(text, GREEN_COLOR);
 }
 
-/*static*/ std::string ItemReforge::ItemIcon(const ItemTemplate* proto, uint32 width, uint32 height, int x, int y)
+/*static*/ void ItemReforge::AppendItemIcon(ReforgeTextWriter& writer, const ItemTemplate* proto, uint32 width, uint32 height, int x, int y)
 {
-    std::ostringstream ss;
-    ss << "|TInterface";
+    writer.Append("|TInterface");
     const ItemDisplayInfoEntry* dispInfo = nullptr;
     if (proto)
     {
         dispInfo = sItemDisplayInfoStore.LookupEntry(proto->DisplayInfoID);
         if (dispInfo)
-            ss << "/ICONS/" << dispInfo->inventoryIcon;
+            writer.Append("/ICONS/").Append(dispInfo->inventoryIcon);
     }
     if (!dispInfo)
-        ss << "/InventoryItems/WoWUnknownItem01";
-    ss << ":" << width << ":" << height << ":" << x << ":" << y << "|t";
-    return ss.str();
+        writer.Append("/InventoryItems/WoWUnknownItem01");
+    writer.Append(':').AppendNumber(width).Append(':').AppendNumber(height).Append(':').AppendNumber(x).Append(':').AppendNumber(y).Append("|t");
 }
 
-/*static*/ std::string ItemReforge::ItemNameWithLocale(const Player* player, const ItemTemplate* itemTemplate, int32 randomPropertyId)
+/*static*/ void ItemReforge::AppendItemName(ReforgeTextWriter& writer, LocaleConstant locale, const ItemTemplate* itemTemplate, int32 randomPropertyId)
 {
-    LocaleConstant loc_idx = player->GetSession()->GetSessionDbLocaleIndex();
-    std::string name = itemTemplate->Name1;
+    // 与 ObjectMgr::GetLocaleString 相同的取值规则, 只是不复制字符串
+    std::string_view name = itemTemplate->Name1;
+    bool localized = false;
     if (ItemLocale const* il = sObjectMgr->GetItemLocale(itemTemplate->ItemId))
-        ObjectMgr::GetLocaleString(il->Name, loc_idx, name);
+    {
+        if (size_t(locale) < il->Name.size() && !il->Name[locale].empty())
+        {
+            name = il->Name[locale];
+            localized = name != itemTemplate->Name1;
+        }
+    }
+    writer.Append(name);
 
     std::array<char const*, 16> const* suffix = nullptr;
     if (randomPropertyId < 0)
@@ -1003,36 +1624,68 @@ void ItemReforge::HandleReload(bool apply) const
     }
     if (suffix)
     {
-        std::string_view test((*suffix)[(name != itemTemplate->Name1) ? loc_idx : DEFAULT_LOCALE]);
+        std::string_view test((*suffix)[localized ? locale : DEFAULT_LOCALE]);
         if (!test.empty())
+            writer.Append(' ').Append(test);
+    }
+}
+
+/*static*/ void ItemReforge::AppendItemLink(ReforgeTextWriter& writer, LocaleConstant locale, const ItemTemplate* itemTemplate, int32 randomPropertyId)
+{
+    writer.Append("|c").AppendHex(ItemQualityColors[itemTemplate->Quality]);
+    writer.Append("|Hitem:").AppendNumber(itemTemplate->ItemId).Append(":0:0:0:0:0:0:0:0:0|h[");
+    AppendItemName(writer, locale, itemTemplate, randomPropertyId);
+    writer.Append("]|h|r");
+}
+
+std::shared_ptr<const std::string> ItemReforge::GetItemLinkForUI(const Item* item, const Player* player) const
+{
+    const ItemTemplate* proto = item->GetTemplate();
+    LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
+    ItemLinkKey key{ proto->ItemId, item->GetItemRandomPropertyId(), uint8(locale) };
+
+    {
+        std::shared_lock<std::shared_mutex> guard(itemLinkLock);
+        ItemLinkContainer::const_iterator itr = itemLinks.find(key);
+        if (itr != itemLinks.end())
         {
-            name += ' ';
-            name += test;
+            ++itemLinksFromCache;
+            return itr->second;
         }
     }
 
-    return name;
+    ReforgeTextBuffer<MAX_ITEM_LINK_LENGTH> text;
+    AppendItemIcon(text, proto);
+    AppendItemLink(text, locale, proto, key.randomPropertyId);
+    std::shared_ptr<const std::string> link = std::make_shared<const std::string>(text.View());
+    ++itemLinksBuilt;
+
+    std::unique_lock<std::shared_mutex> guard(itemLinkLock);
+    // 与物品查询回包缓存一样, 超出上限时整体清空
+    if (itemLinks.size() >= MAX_ITEM_LINKS)
+        itemLinks.clear();
+    itemLinks.emplace(key, link);
+    return link;
 }
 
-/*static*/ std::string ItemReforge::ItemLink(const Player* player, const ItemTemplate* itemTemplate, int32 randomPropertyId)
+void ItemReforge::ClearItemLinkCache()
 {
-    std::stringstream oss;
-    oss << "|c";
-    oss << std::hex << ItemQualityColors[itemTemplate->Quality] << std::dec;
-    oss << "|Hitem:";
-    oss << itemTemplate->ItemId;
-    oss << ":0:0:0:0:0:0:0:0:0|h[";
-    oss << ItemNameWithLocale(player, itemTemplate, randomPropertyId);
-    oss << "]|h|r";
+    std::unique_lock<std::shared_mutex> guard(itemLinkLock);
+    itemLinks.clear();
+}
 
-    return oss.str();
+uint32 ItemReforge::GetItemLinkCacheSize() const
+{
+    std::shared_lock<std::shared_mutex> guard(itemLinkLock);
+    return itemLinks.size();
 }
 
-/*static*/ std::string ItemReforge::ItemLinkForUI(const Item* item, const Player* player)
+uint64 ItemReforge::GetItemLinksBuilt() const
 {
-    const ItemTemplate* proto = item->GetTemplate();
-    std::ostringstream oss;
-    oss << ItemIcon(proto);
-    oss << ItemLink(player, proto, item->GetItemRandomPropertyId());
-    return oss.str();
+    return itemLinksBuilt;
+}
+
+uint64 ItemReforge::GetItemLinksFromCache() const
+{
+    return itemLinksFromCache;
 }
@@ -9,25 +9,24 @@
 #pragma once
 #include "Player.h"
 #include "Item.h"
-
- /*class ItemReforge
-{
-public:
-    static void SetReforgeData(Item* item, uint32 decrease, uint32 increase, uint32 value);
-    static void ClearReforgeData(Item* item);
-
-    static bool HasReforge(const Item* item);
-    static uint32 GetReforgeDecrease(const Item* item);
-    static uint32 GetReforgeIncrease(const Item* item);
-    static uint32 GetReforgeValue(const Item* item);
-
-    static void SaveToDB(Item* item);
-    static void LoadFromDB(Item* item);
-};*/
+#include "WorldPacket.h"
+#include "reforge_text.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
 
 class ItemReforge
 {
 public:
+    static constexpr uint32 MAX_STAT_NAMES = ITEM_MOD_BLOCK_VALUE + 1;
+    // 插件协议用 16 位的 sourceMask 表示可重铸属性, 列表长度不能超过 16
+    static constexpr uint32 MAX_REFORGEABLE_STATS = 15;
+
     struct ReforgingData
     {
         uint32 guid;
@@ -36,28 +35,190 @@ public:
         uint32 stat_increase;
         uint32 stat_value;
     };
+
+    // 批量重铸的一项选择
+    struct ReforgeChoice
+    {
+        uint8 slot;
+        uint32 stat_decrease;
+        uint32 stat_increase;
+    };
+
+    // 优化器建议的一项重铸
+    struct ReforgeSuggestion
+    {
+        uint8 slot;
+        uint32 stat_decrease;
+        uint32 stat_increase;
+        uint32 stat_value;
+    };
+
+    // 重铸 NPC 菜单里当前选中的物品, 保存在角色上, 关闭菜单/下线/超时后丢弃
+    struct GossipSelection : public DataMap::Base
+    {
+        GossipSelection();
+        ~GossipSelection() override;
+
+        ObjectGuid itemGuid;
+        uint32 selectTime = 0;
+    };
+
+    // 装备栏位上已经应用到属性里的重铸
+    struct EquippedReforge
+    {
+        uint32 item_guid;
+        uint32 stat_value;
+        uint8 stat_decrease;
+        uint8 stat_increase;
+        uint8 stats_count;
+        bool reforged;
+    };
 private:
     static constexpr float PERCENTAGE_MIN = 10.0f;
     static constexpr float PERCENTAGE_MAX = 90.0f;
     static constexpr const char* RED_COLOR = "b50505";
     static constexpr const char* GREEN_COLOR = "056e3a";
-    static constexpr uint32 MAX_REFORGEABLE_STATS = 15;
+    static constexpr const char* UNKNOWN_STRING = "未知";
+
+    enum StringType : uint8
+    {
+        STRING_TYPE_STAT = 0,
+        STRING_TYPE_SLOT = 1
+    };
+    static constexpr uint32 MAX_ITEM_PACKETS = 65536;
+
+    static size_t HashCombine(size_t seed, uint64 value)
+    {
+        return seed ^ (std::hash<uint64>()(value) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    struct ItemPacketKey
+    {
+        uint32 entry;
+        uint16 stat_value;
+        uint8 locale;
+        uint8 stat_decrease;
+        uint8 stat_increase;
+
+        bool operator==(const ItemPacketKey& other) const = default;
+    };
+
+    struct ItemPacketKeyHash
+    {
+        size_t operator()(const ItemPacketKey& key) const
+        {
+            // 模板/数值/语言各占互不重叠的位, 两个属性类型再合并进去
+            size_t seed = std::hash<uint64>()(uint64(key.entry) | (uint64(key.stat_value) << 32) | (uint64(key.locale) << 48));
+            return HashCombine(seed, (uint64(key.stat_decrease) << 8) | key.stat_increase);
+        }
+    };
+
+    typedef std::unordered_map<ItemPacketKey, std::shared_ptr<WorldPacket const>, ItemPacketKeyHash> ItemPacketContainer;
+
+    static constexpr uint32 MAX_ITEM_LINKS = 65536;
+    static constexpr uint32 MAX_ITEM_LINK_LENGTH = 512;
+
+    struct ItemLinkKey
+    {
+        uint32 entry;
+        int32 randomPropertyId;
+        uint8 locale;
+
+        bool operator==(const ItemLinkKey& other) const = default;
+    };
+
+    struct ItemLinkKeyHash
+    {
+        size_t operator()(const ItemLinkKey& key) const
+        {
+            return HashCombine(std::hash<uint64>()((uint64(key.entry) << 32) | uint32(key.randomPropertyId)), key.locale);
+        }
+    };
+
+    typedef std::unordered_map<ItemLinkKey, std::shared_ptr<const std::string>, ItemLinkKeyHash> ItemLinkContainer;
+
+    static constexpr const char* SENT_ITEM_PACKETS_KEY = "mod_reforging_sent_item_packets";
+    static constexpr const char* PLAYER_STATE_KEY = "mod_reforging_player_state";
+    static constexpr const char* GOSSIP_SELECTION_KEY = "mod_reforging_gossip_selection";
+    static constexpr uint32 GOSSIP_SELECTION_TIMEOUT_MS = 5 * MINUTE * IN_MILLISECONDS;
+
+    // 本次会话已发给客户端的物品查询结果, 按模板记录, 随 Player 一起释放
+    struct SentItemPackets : public DataMap::Base
+    {
+        typedef std::unordered_map<uint32, ItemPacketKey> EntryContainer;
+
+        EntryContainer entries;
+    };
+
+    // 角色当前的属性里是否包含重铸(开关切换后由重载任务逐个角色更新), 以及按装备栏位解析好的重铸
+    struct ReforgePlayerState : public DataMap::Base
+    {
+        typedef std::vector<std::pair<uint16, int32>> PendingEffectContainer;
+
+        bool applied = false;
+        // 角色的重铸每次变化都递增, 供菜单缓存判断是否过期
+        uint32 gearVersion = 0;
+        std::array<EquippedReforge, INVENTORY_SLOT_BAG_END> slots{};
+        // 尚未应用的属性效果: (效果类型 << 8 | 目标, 累计值)
+        PendingEffectContainer pendingEffects;
+    };
     
     bool enabled;
     std::vector<uint32> reforgeableStats;
     float percentage;
 	uint32 NeedMoney; 
 
-	ItemReforge();
-	~ItemReforge();
+    // 物品查询回包缓存, 同一模板/语言/重铸组合的包在所有会话之间共享
+    mutable std::shared_mutex itemPacketLock;
+    mutable ItemPacketContainer itemPackets;
+    mutable std::atomic<uint64> itemPacketsBuilt;
+    mutable std::atomic<uint64> itemPacketsFromCache;
+    mutable std::atomic<uint64> itemPacketsSkipped;
+    // 菜单里带图标的物品链接缓存, 按模板/随机属性/语言在所有会话之间共享
+    mutable std::shared_mutex itemLinkLock;
+    mutable ItemLinkContainer itemLinks;
+    mutable std::atomic<uint64> itemLinksBuilt;
+    mutable std::atomic<uint64> itemLinksFromCache;
+    // 任何已应用的重铸变化时递增, 使各线程记住的上一次结果失效
+    mutable std::atomic<uint32> equippedReforgeEpoch;
+
+    // 按语言和 ItemModType / 装备栏位索引的名称, 数据库里的翻译保存在 localizedStrings
+    std::array<std::array<std::string_view, MAX_STAT_NAMES>, TOTAL_LOCALES> statNames;
+    std::array<std::array<std::string_view, EQUIPMENT_SLOT_END>, TOTAL_LOCALES> slotNames;
+    std::deque<std::string> localizedStrings;
 
-	typedef std::unordered_map<uint32, ReforgingData> ReforgingDataContainer;
+    // 优化器的属性权重和上限(按 ItemModType 索引, 上限为 0 表示不设上限)
+    std::array<float, MAX_STAT_NAMES> optimizerWeights;
+    std::array<uint32, MAX_STAT_NAMES> optimizerCaps;
+    mutable std::atomic<uint64> optimizerRuns;
+    mutable std::atomic<uint64> optimizerTime;
+    mutable std::atomic<uint32> optimizerMaxTime;
 
-    ReforgingDataContainer reforgingDataMap;
+    bool verifyDifferential;
+    std::atomic<uint64> differentialApplies;
+    std::atomic<uint64> differentialApplyTime;
+    std::atomic<uint64> fullApplies;
+    std::atomic<uint64> fullApplyTime;
+    mutable std::atomic<uint64> differentialMismatches;
+    std::atomic<uint32> gossipSelections;
+    std::atomic<uint32> configVersion;
+    std::atomic<uint64> menusBuilt;
+    std::atomic<uint64> menusFromCache;
+    std::atomic<uint64> statEffectsQueued;
+    mutable std::atomic<uint64> statEffectsApplied;
 
-    void CleanupDB() const;
+	ItemReforge();
+	~ItemReforge();
 
-    static std::string TextWithColor(const std::string& text, const std::string& color);
+    ReforgePlayerState* GetPlayerState(Player* player) const;
+    void FillDefaultStrings();
+    bool CanApplyDifferential(const Item* item) const;
+    void ChangeReforge(Player* player, Item* item, const std::optional<ReforgingData>& reforgingData, bool flush = true);
+    bool MakeReforgingData(const Player* player, const Item* item, uint32 statDecrease, uint32 statIncrease, ReforgingData& reforgingData) const;
+    void VerifyDifferential(Player* player, Item* item) const;
+    ItemPacketKey MakeItemPacketKey(const Player* player, const Item* item, const std::optional<ReforgingData>& reforgingData) const;
+    void SendItemPacket(Player* player, const ItemPacketKey& key, const std::optional<ReforgingData>& reforgingData) const;
+    std::shared_ptr<WorldPacket const> BuildItemPacket(ItemTemplate const* pProto, int loc_idx, const std::optional<ReforgingData>& reforgingData) const;
 public:
 
     static void SetReforgeData(Item* item, uint32 decrease, uint32 increase, uint32 value);
@@ -67,6 +228,8 @@ public:
     static constexpr float PERCENTAGE_DEFAULT = 40.0f;
     static constexpr int VISUAL_FEEDBACK_SPELL_ID = 46331;
     static constexpr uint32 NEEDMONEY_DEFAULT = 80000;
+    static constexpr const char* DefaultOptimizerWeights = "31:1.0,37:0.9,32:0.8,36:0.8,44:0.7,43:0.3,6:0.2";
+    static constexpr const char* DefaultOptimizerCaps = "31:263,37:214";
 
 
     static bool HasReforge(const Item* item);
@@ -89,11 +252,19 @@ public:
     float GetPercentage() const;
     void SetNeedMoney(uint32 value);
     uint32 GetNeedMoney() const;
-    void LoadFromDB();
+    void SetVerifyDifferential(bool value);
+    uint64 GetDifferentialApplies() const;
+    uint64 GetDifferentialApplyTime() const;
+    uint64 GetFullApplies() const;
+    uint64 GetFullApplyTime() const;
+    uint64 GetDifferentialMismatches() const;
+    void SetOptimizerWeights(const std::string& weights);
+    void SetOptimizerCaps(const std::string& caps);
 
-    std::string GetSlotIcon(uint8 slot, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0) const;
-    std::string GetSlotName(uint8 slot) const;
-    std::string StatTypeToString(uint32 statType) const;
+    static void AppendSlotIcon(ReforgeTextWriter& writer, uint8 slot, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0);
+    std::string_view GetSlotName(uint8 slot, LocaleConstant locale) const;
+    std::string_view StatTypeToString(uint32 statType, LocaleConstant locale) const;
+    void LoadStrings();
 
     bool IsReforgeable(const Player* player, const Item* item) const;
     bool IsAlreadyReforged(const Item* item) const;
@@ -103,27 +274,56 @@ public:
     const _ItemStat* FindItemStat(const std::vector<_ItemStat>& stats, uint32 statType) const;
 
     bool Reforge(Player* player, ObjectGuid itemGuid, uint32 statDecrease, uint32 statIncrease);
+    bool ReforgeBatch(Player* player, const std::vector<ReforgeChoice>& choices);
+    float SuggestReforges(Player* player, std::vector<ReforgeSuggestion>& suggestions) const;
+    uint64 GetOptimizerRuns() const;
+    uint64 GetOptimizerTime() const;
+    uint32 GetOptimizerMaxTime() const;
+    void SetGossipSelection(Player* player, ObjectGuid itemGuid);
+    ObjectGuid GetGossipSelection(Player* player) const;
+    void ClearGossipSelection(Player* player) const;
+    uint32 GetGossipSelectionCount() const;
+    uint32 GetGearVersion(Player* player) const;
+    uint32 GetConfigVersion() const;
+    void CountMenuBuild(bool cached);
+    uint64 GetMenusBuilt() const;
+    uint64 GetMenusFromCache() const;
     void SendItemPacket(Player* player, const Item* item) const;
-    void SendItemPackets(Player* player) const;
-    void HandleReload(Player* player, bool apply) const;
-    void HandleReload(bool apply) const;
-    const ReforgingData* GetReforgingData(const Item* item) const;
+    uint32 SendReforgedItemPackets(Player* player) const;
+    void ClearItemPacketCache();
+    uint32 GetItemPacketCacheSize() const;
+    uint64 GetItemPacketsBuilt() const;
+    uint64 GetItemPacketsFromCache() const;
+    uint64 GetItemPacketsSkipped() const;
+    uint32 ResetReforgedItemPackets(Player* player) const;
+    bool AreReforgesApplied(Player* player) const;
+    bool ReloadPlayer(Player* player) const;
+    bool GetEquippedReforge(Player* player, uint8 slot, EquippedReforge& reforge) const;
+    void InvalidateEquippedReforge(Player* player, const Item* item) const;
+    uint32 BenchmarkReapply(Player* player, uint32 iterations, bool resolve) const;
+    std::optional<ReforgingData> GetReforgingData(const Item* item) const;
     std::vector<Item*> GetPlayerItems(const Player* player, bool inBankAlso) const;
     bool CanRemoveReforge(const Item* item) const;
     bool RemoveReforge(Player* player, ObjectGuid itemGuid);
     bool RemoveReforge(Player* player, Item* item);
     void VisualFeedback(Player* player);
-    void HandleCharacterRemove(uint32 guid);
 
     void HandleStatModifier(Player* player, uint32 statType, int32 val, bool apply);
+    void FlushStatModifiers(Player* player) const;
+    uint64 GetStatEffectsQueued() const;
+    uint64 GetStatEffectsApplied() const;
 
     static void SendMessage(Player* player, const std::string& message);
-    static std::string TextRed(const std::string& text);
-    static std::string TextGreen(const std::string& text);
-    static std::string ItemIcon(const ItemTemplate* proto, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0);
-    static std::string ItemNameWithLocale(const Player* player, const ItemTemplate* itemTemplate, int32 randomPropertyId);
-    static std::string ItemLink(const Player* player, const ItemTemplate* itemTemplate, int32 randomPropertyId);
-    static std::string ItemLinkForUI(const Item* item, const Player* player);
+    static void AppendRed(ReforgeTextWriter& writer, std::string_view text);
+    static void AppendGreen(ReforgeTextWriter& writer, std::string_view text);
+    static void AppendItemIcon(ReforgeTextWriter& writer, const ItemTemplate* proto, uint32 width = 30, uint32 height = 30, int x = 0, int y = 0);
+    static void AppendItemName(ReforgeTextWriter& writer, LocaleConstant locale, const ItemTemplate* itemTemplate, int32 randomPropertyId);
+    static void AppendItemLink(ReforgeTextWriter& writer, LocaleConstant locale, const ItemTemplate* itemTemplate, int32 randomPropertyId);
+    std::shared_ptr<const std::string> GetItemLinkForUI(const Item* item, const Player* player) const;
+    void ClearItemLinkCache();
+    uint32 GetItemLinkCacheSize() const;
+    uint64 GetItemLinksBuilt() const;
+    uint64 GetItemLinksFromCache() const;
 };
 
 #define sItemReforge ItemReforge::instance()
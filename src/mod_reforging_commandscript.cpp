@@ -0,0 +1,162 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "ScriptMgr.h"
+#include "Chat.h"
+#include "StringFormat.h"
+#include "item_reforge.h"
+#include "reforge_addon.h"
+#include "reforge_login_queue.h"
+#include "reforge_reload_job.h"
+#include "reforge_reaper.h"
+#include "reforge_snapshot.h"
+#include "reforge_store.h"
+#include "reforge_write_queue.h"
+
+using namespace Acore::ChatCommands;
+
+class mod_reforging_commandscript : public CommandScript
+{
+private:
+    static constexpr uint32 BENCH_ITERATIONS = 100;
+public:
+    mod_reforging_commandscript() : CommandScript("mod_reforging_commandscript") {}
+
+    ChatCommandTable GetCommands() const override
+    {
+        static ChatCommandTable reforgeCommandTable =
+        {
+            { "stats",  HandleReforgeStatsCommand,  SEC_ADMINISTRATOR, Console::Yes },
+            { "reaper", HandleReforgeReaperCommand, SEC_ADMINISTRATOR, Console::Yes },
+            { "bench",  HandleReforgeBenchCommand,  SEC_ADMINISTRATOR, Console::No }
+        };
+
+        static ChatCommandTable commandTable =
+        {
+            { "reforge", reforgeCommandTable }
+        };
+
+        return commandTable;
+    }
+
+    static bool HandleReforgeStatsCommand(ChatHandler* handler)
+    {
+        uint64 syncQueries = ReforgeStore::GetSyncQueryCount();
+        uint64 startupQueries = sReforgeStore->GetStartupSyncQueryCount();
+
+        handler->PSendSysMessage("Reforges in memory: {} across {} characters ({} KB)", sReforgeStore->GetReforgeCount(), sReforgeStore->GetReforgeOwnerCount(), sReforgeStore->GetMemoryUsage() / 1024);
+        if (sReforgeStore->GetLazyLoad())
+            handler->PSendSysMessage("Lazy load: {} characters resident, {} loads issued, {} arrived after login",
+                sReforgeStore->GetLoadedCharacterCount(), sReforgeStore->GetCharacterLoadsIssued(), sReforgeStore->GetCharacterLoadsLate());
+        else if (sReforgeStore->GetMaxEntries() > 0)
+            handler->PSendSysMessage("Cache: limit {} reforges, {} logins resident, {} reloaded, {} reforges of {} characters evicted, {} characters evicted now",
+                sReforgeStore->GetMaxEntries(), sReforgeStore->GetCacheHits(), sReforgeStore->GetCacheMisses(),
+                sReforgeStore->GetEvictedEntryCount(), sReforgeStore->GetEvictedOwnerCount(), sReforgeStore->GetColdOwnerCount());
+        if (sReforgeSnapshot->GetEnabled())
+            handler->PSendSysMessage("Snapshot: database generation {}, snapshot generation {}, {} written (last {} ms), {}",
+                sReforgeWriteQueue->GetGeneration(), sReforgeSnapshot->GetWrittenGeneration(), sReforgeSnapshot->GetWriteCount(), sReforgeSnapshot->GetLastWriteTime(),
+                sReforgeSnapshot->IsLoaded() ? Acore::StringFormat("loaded at startup in {} ms", sReforgeSnapshot->GetLastLoadTime()) : "not used at startup");
+        uint64 packetsBuilt = sItemReforge->GetItemPacketsBuilt();
+        uint64 packetsCached = sItemReforge->GetItemPacketsFromCache();
+        handler->PSendSysMessage("Item query packets: {} built, {} served from cache ({}% hit rate), {} cached",
+            packetsBuilt, packetsCached, packetsBuilt + packetsCached ? packetsCached * 100 / (packetsBuilt + packetsCached) : 0, sItemReforge->GetItemPacketCacheSize());
+        uint64 linksBuilt = sItemReforge->GetItemLinksBuilt();
+        uint64 linksCached = sItemReforge->GetItemLinksFromCache();
+        handler->PSendSysMessage("Item links: {} built, {} served from cache ({}% hit rate), {} cached",
+            linksBuilt, linksCached, linksBuilt + linksCached ? linksCached * 100 / (linksBuilt + linksCached) : 0, sItemReforge->GetItemLinkCacheSize());
+        uint64 optimizerRuns = sItemReforge->GetOptimizerRuns();
+        handler->PSendSysMessage("Optimizer: {} suggestions, {:.1f} us average, {} us slowest",
+            optimizerRuns, optimizerRuns ? float(sItemReforge->GetOptimizerTime()) / optimizerRuns : 0.0f, sItemReforge->GetOptimizerMaxTime());
+        if (sReforgeAddon->GetEnabled())
+            handler->PSendSysMessage("Addon protocol: {} messages received, {} sent, {} commands applied, {} rejected",
+                sReforgeAddon->GetMessagesReceived(), sReforgeAddon->GetMessagesSent(), sReforgeAddon->GetCommandsApplied(), sReforgeAddon->GetCommandsRejected());
+        handler->PSendSysMessage("Login push: {} waiting for client, {} queued, {} ready by client, {} by timeout, last delay {} ms, {} packets sent",
+            sReforgeLoginQueue->GetPendingCount(), sReforgeLoginQueue->GetQueuedCount(), sReforgeLoginQueue->GetReadyByClientCount(),
+            sReforgeLoginQueue->GetReadyByTimeoutCount(), sReforgeLoginQueue->GetLastReadyDelay(), sReforgeLoginQueue->GetPacketsSent());
+        if (sReforgeReloadJob->GetState() == ReforgeReloadJob::State::RUNNING)
+            handler->PSendSysMessage("Enable reload: running, {}/{} players checked, {} reloaded, {} ms so far",
+                sReforgeReloadJob->GetProcessedCount(), sReforgeReloadJob->GetTotalCount(), sReforgeReloadJob->GetReloadedCount(), sReforgeReloadJob->GetDuration());
+        else if (sReforgeReloadJob->GetState() == ReforgeReloadJob::State::FINISHED)
+            handler->PSendSysMessage("Enable reload: finished, {} players checked, {} reloaded in {} ms",
+                sReforgeReloadJob->GetTotalCount(), sReforgeReloadJob->GetReloadedCount(), sReforgeReloadJob->GetDuration());
+        uint64 differentialApplies = sItemReforge->GetDifferentialApplies();
+        uint64 fullApplies = sItemReforge->GetFullApplies();
+        handler->PSendSysMessage("Reforge stat updates: {} differential (avg {} us, {} verify mismatches), {} full reapply (avg {} us)",
+            differentialApplies, differentialApplies ? sItemReforge->GetDifferentialApplyTime() / differentialApplies : 0, sItemReforge->GetDifferentialMismatches(),
+            fullApplies, fullApplies ? sItemReforge->GetFullApplyTime() / fullApplies : 0);
+        handler->PSendSysMessage("Reforge stat effects: {} queued, {} applied after merging", sItemReforge->GetStatEffectsQueued(), sItemReforge->GetStatEffectsApplied());
+        handler->PSendSysMessage("Reforger menus: {} selections held, {} slot menus built, {} resent from cache",
+            sItemReforge->GetGossipSelectionCount(), sItemReforge->GetMenusBuilt(), sItemReforge->GetMenusFromCache());
+        handler->PSendSysMessage("Login item packets skipped as already sent this session: {}", sItemReforge->GetItemPacketsSkipped());
+        handler->PSendSysMessage("Synchronous DB queries: {} total, {} at startup, {} since startup", syncQueries, startupQueries, syncQueries - startupQueries);
+        handler->PSendSysMessage("Write queue: {} pending, flush in flight: {}", sReforgeWriteQueue->GetQueueDepth(), sReforgeWriteQueue->IsFlushInFlight() ? "yes" : "no");
+        handler->PSendSysMessage("Write queue: {} flushes ({} failed), {} changes in {} statements, {} changes coalesced",
+            sReforgeWriteQueue->GetFlushCount(), sReforgeWriteQueue->GetFailedFlushCount(), sReforgeWriteQueue->GetFlushedMutationCount(),
+            sReforgeWriteQueue->GetFlushedStatementCount(), sReforgeWriteQueue->GetCoalescedMutationCount());
+        handler->PSendSysMessage("Write queue flush latency: last {} ms, avg {} ms, max {} ms",
+            sReforgeWriteQueue->GetLastFlushLatency(), sReforgeWriteQueue->GetAverageFlushLatency(), sReforgeWriteQueue->GetMaxFlushLatency());
+        return true;
+    }
+
+    static const char* ReaperStateName(ReforgeReaper::State state)
+    {
+        switch (state)
+        {
+            case ReforgeReaper::State::RUNNING:
+                return "running";
+            case ReforgeReaper::State::FINISHED:
+                return "finished";
+            default:
+                return "idle";
+        }
+    }
+
+    // .reforge reaper [run|dryrun]
+    static bool HandleReforgeReaperCommand(ChatHandler* handler, Optional<std::string> mode)
+    {
+        if (mode)
+        {
+            if (*mode != "run" && *mode != "dryrun")
+            {
+                handler->SendSysMessage("Usage: .reforge reaper [run|dryrun]");
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+
+            if (!sReforgeReaper->StartPass(*mode == "dryrun"))
+            {
+                handler->SendSysMessage("The orphan reaper is already running.");
+                handler->SetSentErrorMessage(true);
+                return false;
+            }
+        }
+
+        handler->PSendSysMessage("Orphan reaper: {}{}, cursor item_guid {}, {} ms", ReaperStateName(sReforgeReaper->GetState()),
+            sReforgeReaper->IsDryRun() ? " (dry run)" : "", sReforgeReaper->GetCursor(), sReforgeReaper->GetPassDuration());
+        handler->PSendSysMessage("Orphan reaper: {} rows scanned in {} batches, {} orphans found, {} removed, {} skipped (owner online)",
+            sReforgeReaper->GetScannedRowCount(), sReforgeReaper->GetBatchCount(), sReforgeReaper->GetOrphansFound(),
+            sReforgeReaper->GetOrphansRemoved(), sReforgeReaper->GetOrphansSkipped());
+        return true;
+    }
+
+    // .reforge bench
+    // 只对自己的角色测试, 次数固定, 避免在别人的在线角色上反复卸下/应用装备属性
+    static bool HandleReforgeBenchCommand(ChatHandler* handler)
+    {
+        Player* player = handler->GetPlayer();
+        if (!player)
+            return false;
+
+        uint32 resolved = sItemReforge->BenchmarkReapply(player, BENCH_ITERATIONS, true);
+        uint32 cached = sItemReforge->BenchmarkReapply(player, BENCH_ITERATIONS, false);
+        handler->PSendSysMessage("Full equipment reapply x{}: {} us resolving every item, {} us from the slot table ({:.2f} / {:.2f} us per reapply)",
+            BENCH_ITERATIONS, resolved, cached, float(resolved) / BENCH_ITERATIONS, float(cached) / BENCH_ITERATIONS);
+        return true;
+    }
+};
+
+void AddSC_mod_reforging_commandscript()
+{
+    new mod_reforging_commandscript();
+}
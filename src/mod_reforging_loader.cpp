@@ -6,13 +6,8 @@ void AddSC_mod_reforging_worldscript();
 void AddSC_npc_reforger();
 void AddSC_mod_reforging_playerscript();
 void AddSC_mod_reforging_itemscript();
-
-void Addmod_reforging_itemscript();
-
-extern "C" void AddSC_mod_reforging_new()
-{
-    Addmod_reforging_itemscript();
-}
+void AddSC_mod_reforging_commandscript();
+void AddSC_mod_reforging_serverscript();
 
 void Addmod_reforgingScripts()
 {
@@ -20,5 +15,7 @@ void Addmod_reforgingScripts()
     AddSC_npc_reforger();
     AddSC_mod_reforging_playerscript();
     AddSC_mod_reforging_itemscript();
+    AddSC_mod_reforging_commandscript();
+    AddSC_mod_reforging_serverscript();
 }
 
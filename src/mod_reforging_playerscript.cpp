@@ -6,35 +6,22 @@
 #include "DatabaseEnv.h"
 #include "Player.h"
 #include "item_reforge.h"
+#include "reforge_addon.h"
+#include "reforge_login_queue.h"
+#include "reforge_store.h"
 
 class mod_reforging_playerscript : public PlayerScript
 {
-private:
-    class SendReforgePackets : public BasicEvent
-    {
-    public:
-        SendReforgePackets(Player* player) : player(player)
-        {
-            player->m_Events.AddEvent(this, player->m_Events.CalculateTime(DELAY_MS));
-        }
-
-        bool Execute(uint64 /*e_time*/, uint32 /*p_time*/)
-        {
-            sItemReforge->SendItemPackets(player);
-            return true;
-        }
-    private:
-        static constexpr uint64 DELAY_MS = 3000;
-
-        Player* player;
-    };
 public:
     mod_reforging_playerscript() : PlayerScript("mod_reforging_playerscript",
         {
             PLAYERHOOK_ON_AFTER_MOVE_ITEM_FROM_INVENTORY,
             PLAYERHOOK_ON_DELETE_FROM_DB,
             PLAYERHOOK_ON_LOGIN,
-            PLAYERHOOK_ON_APPLY_ITEM_MODS_BEFORE
+            PLAYERHOOK_ON_LOGOUT,
+            PLAYERHOOK_ON_APPLY_ITEM_MODS_BEFORE,
+            PLAYERHOOK_ON_UPDATE,
+            PLAYERHOOK_CAN_PLAYER_USE_PRIVATE_CHAT
         }) {}
 
     void OnPlayerAfterMoveItemFromInventory(Player* player, Item* it, uint8 /*bag*/, uint8 /*slot*/, bool /*update*/) override
@@ -44,34 +31,46 @@ public:
 
     void OnPlayerDeleteFromDB(CharacterDatabaseTransaction trans, uint32 guid) override
     {
-        trans->Append("DELETE FROM character_reforging WHERE guid = {}", guid);
-        sItemReforge->HandleCharacterRemove(guid);
+        sReforgeStore->RemoveCharacter(trans, guid);
     }
 
     void OnPlayerLogin(Player* player) override
     {
-        new SendReforgePackets(player);
+        sReforgeStore->HandleLogin(player->GetGUID().GetCounter());
+        sReforgeLoginQueue->HandleLogin(player->GetGUID().GetCounter());
     }
 
-    void OnPlayerApplyItemModsBefore(Player* player, uint8 slot, bool apply, uint8 itemProtoStatNumber, uint32 statType, int32& val) override
+    void OnPlayerLogout(Player* player) override
     {
-        Item* item = player->GetItemByPos(INVENTORY_SLOT_BAG_0, slot);
-        if (!item)
-            return;
+        sReforgeStore->HandleLogout(player->GetGUID().GetCounter());
+        sReforgeLoginQueue->HandleLogout(player->GetGUID().GetCounter());
+    }
+
+    void OnPlayerUpdate(Player* player, uint32 /*p_time*/) override
+    {
+        sItemReforge->FlushStatModifiers(player);
+    }
+
+    // 插件消息以悄悄话发给自己, 由插件协议处理后不再投递
+    bool OnPlayerCanUseChat(Player* player, uint32 type, uint32 language, std::string& msg, Player* receiver) override
+    {
+        if (type != CHAT_MSG_WHISPER || language != LANG_ADDON || receiver != player)
+            return true;
 
-        ItemTemplate const* proto = item->GetTemplate();
-        if (!proto || proto->StatsCount == 0)
+        return !sReforgeAddon->HandleMessage(player, msg);
+    }
+
+    void OnPlayerApplyItemModsBefore(Player* player, uint8 slot, bool apply, uint8 itemProtoStatNumber, uint32 statType, int32& val) override
+    {
+        ItemReforge::EquippedReforge reforging;
+        if (!sItemReforge->GetEquippedReforge(player, slot, reforging))
             return;
 
-        const ItemReforge::ReforgingData* reforging = sItemReforge->GetReforgingData(item);
-        if (reforging != nullptr)
-        {
-            if (itemProtoStatNumber == proto->StatsCount - 1)
-                sItemReforge->HandleStatModifier(player, reforging->stat_increase, reforging->stat_value, apply);
+        if (itemProtoStatNumber == reforging.stats_count - 1)
+            sItemReforge->HandleStatModifier(player, reforging.stat_increase, reforging.stat_value, apply);
 
-            if (statType == reforging->stat_decrease)
-                val -= reforging->stat_value;
-        }
+        if (statType == reforging.stat_decrease)
+            val -= reforging.stat_value;
     }
 };
 
@@ -0,0 +1,45 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "ScriptMgr.h"
+#include "ObjectGuid.h"
+#include "Opcodes.h"
+#include "WorldPacket.h"
+#include "WorldSession.h"
+#include "reforge_login_queue.h"
+#include "reforge_store.h"
+
+class mod_reforging_serverscript : public ServerScript
+{
+public:
+    mod_reforging_serverscript() : ServerScript("mod_reforging_serverscript",
+        {
+            SERVERHOOK_CAN_PACKET_RECEIVE
+        }) {}
+
+    bool CanPacketReceive(WorldSession* session, WorldPacket& packet) override
+    {
+        if (packet.GetOpcode() == CMSG_PLAYER_LOGIN && session && packet.size() >= sizeof(uint64))
+        {
+            // 只预取本账号的角色(角色列表发送时记录), 客户端发来的 guid 不可信
+            ObjectGuid guid(packet.read<uint64>(0));
+            if (session->IsLegitCharacterForAccount(guid))
+                sReforgeStore->PrefetchCharacter(guid.GetCounter());
+        }
+        // 客户端载入完成后设置移动对象, 此时才能正确处理物品查询结果
+        else if (packet.GetOpcode() == CMSG_SET_ACTIVE_MOVER && session && packet.size() >= sizeof(uint64))
+        {
+            ObjectGuid guid(packet.read<uint64>(0));
+            if (session->IsLegitCharacterForAccount(guid))
+                sReforgeLoginQueue->HandleClientReady(guid.GetCounter());
+        }
+
+        return true;
+    }
+};
+
+void AddSC_mod_reforging_serverscript()
+{
+    new mod_reforging_serverscript();
+}
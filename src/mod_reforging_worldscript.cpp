@@ -5,6 +5,13 @@
 #include "ScriptMgr.h"
 #include "Config.h"
 #include "item_reforge.h"
+#include "reforge_addon.h"
+#include "reforge_login_queue.h"
+#include "reforge_reaper.h"
+#include "reforge_reload_job.h"
+#include "reforge_snapshot.h"
+#include "reforge_store.h"
+#include "reforge_write_queue.h"
 
 class mod_reforging_worldscript : public WorldScript
 {
@@ -12,27 +19,82 @@ public:
     mod_reforging_worldscript() : WorldScript("mod_reforging_worldscript",
         {
             WORLDHOOK_ON_AFTER_CONFIG_LOAD,
-            WORLDHOOK_ON_BEFORE_WORLD_INITIALIZED
+            WORLDHOOK_ON_BEFORE_WORLD_INITIALIZED,
+            WORLDHOOK_ON_STARTUP,
+            WORLDHOOK_ON_UPDATE,
+            WORLDHOOK_ON_SHUTDOWN
         }) {}
 
     void OnAfterConfigLoad(bool reload) override
     {
         bool reforgeEnableChanged = reload && sItemReforge->GetEnabled() != sConfigMgr->GetOption<bool>("Reforging.Enable", true);
-        if (reforgeEnableChanged)
-            sItemReforge->HandleReload(false);
 
         sItemReforge->SetEnabled(sConfigMgr->GetOption<bool>("Reforging.Enable", true));
         sItemReforge->SetReforgeableStats(sConfigMgr->GetOption<std::string>("Reforging.ReforgeableStats", ItemReforge::DefaultReforgeableStats));
         sItemReforge->SetPercentage(sConfigMgr->GetOption<float>("Reforging.Percentage", ItemReforge::PERCENTAGE_DEFAULT));
         sItemReforge->SetNeedMoney(sConfigMgr->GetOption<uint32>("Reforging.NeedMoney", ItemReforge::NEEDMONEY_DEFAULT));
+        sItemReforge->SetVerifyDifferential(sConfigMgr->GetOption<bool>("Reforging.VerifyDifferential", false));
+        sItemReforge->SetOptimizerWeights(sConfigMgr->GetOption<std::string>("Reforging.Optimizer.Weights", ItemReforge::DefaultOptimizerWeights));
+        sItemReforge->SetOptimizerCaps(sConfigMgr->GetOption<std::string>("Reforging.Optimizer.Caps", ItemReforge::DefaultOptimizerCaps));
+        if (!reload)
+        {
+            sReforgeStore->SetLazyLoad(sConfigMgr->GetOption<bool>("Reforging.LazyLoad", false));
+            sReforgeStore->SetMigrateLegacyColumns(sConfigMgr->GetOption<bool>("Reforging.MigrateLegacyColumns", false));
+            sReforgeStore->SetLoadThreads(sConfigMgr->GetOption<uint32>("Reforging.Load.Threads", 4));
+            sReforgeSnapshot->SetEnabled(sConfigMgr->GetOption<bool>("Reforging.Snapshot.Enable", false));
+            sReforgeSnapshot->SetPath(sConfigMgr->GetOption<std::string>("Reforging.Snapshot.Path", "reforge_snapshot.bin"));
+        }
+        sReforgeLoginQueue->SetReadyTimeout(sConfigMgr->GetOption<uint32>("Reforging.Login.ReadyTimeout", 5000));
+        sReforgeLoginQueue->SetPacketsPerTick(sConfigMgr->GetOption<uint32>("Reforging.Login.PacketsPerTick", 500));
+        sReforgeSnapshot->SetInterval(sConfigMgr->GetOption<uint32>("Reforging.Snapshot.Interval", 600));
+        sReforgeStore->SetMaxEntries(sConfigMgr->GetOption<uint32>("Reforging.Cache.MaxEntries", 0));
+        sReforgeReloadJob->SetPlayersPerTick(sConfigMgr->GetOption<uint32>("Reforging.Reload.PlayersPerTick", 50));
+        sReforgeAddon->SetEnabled(sConfigMgr->GetOption<bool>("Reforging.Addon.Enable", true));
+        sReforgeReaper->SetEnabled(sConfigMgr->GetOption<bool>("Reforging.Reaper.Enable", true));
+        sReforgeReaper->SetDryRun(sConfigMgr->GetOption<bool>("Reforging.Reaper.DryRun", false));
+        sReforgeReaper->SetRowsPerBatch(sConfigMgr->GetOption<uint32>("Reforging.Reaper.RowsPerBatch", 1000));
+        sReforgeReaper->SetBatchesPerSecond(sConfigMgr->GetOption<uint32>("Reforging.Reaper.BatchesPerSecond", 2));
+
+        // 重载配置时物品模板或本地化可能已经变化, 缓存的物品查询包和物品链接需要重建
+        if (reload)
+        {
+            sItemReforge->ClearItemPacketCache();
+            sItemReforge->ClearItemLinkCache();
+        }
 
+        // 在线角色的属性由重载任务在之后的 tick 中分批更新
         if (reforgeEnableChanged)
-            sItemReforge->HandleReload(true);
+            sReforgeReloadJob->Start();
     }
 
     void OnBeforeWorldInitialized() override
     {
-        sItemReforge->LoadFromDB();
+        sItemReforge->LoadStrings();
+
+        // 在后台分区载入, 世界初始化完成后才等待结果
+        sReforgeStore->StartLoading();
+    }
+
+    void OnStartup() override
+    {
+        sReforgeStore->FinishLoading();
+        sReforgeReaper->Start();
+    }
+
+    void OnUpdate(uint32 diff) override
+    {
+        sReforgeStore->Update(diff);
+        sReforgeLoginQueue->Update();
+        sReforgeReloadJob->Update();
+        sReforgeReaper->Update(diff);
+        sReforgeWriteQueue->Update();
+        sReforgeSnapshot->Update(diff);
+    }
+
+    void OnShutdown() override
+    {
+        sReforgeWriteQueue->FlushNow();
+        sReforgeSnapshot->WriteNow();
     }
 };
 
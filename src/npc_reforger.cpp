@@ -7,65 +7,141 @@
 #include "Creature.h"
 #include "Player.h"
 #include "StringConvert.h"
+#include "Tokenize.h"
 #include "item_reforge.h"
+#include "reforge_text.h"
+#include <array>
 
 class npc_reforger : public CreatureScript
 {
 private:
-    std::unordered_map<uint32, ObjectGuid> itemMap;
-
     bool CloseGossip(Player* player, bool retVal = true)
     {
+        sItemReforge->ClearGossipSelection(player);
         CloseGossipMenuFor(player);
         return retVal;
     }
 
-    bool AddEquipmentSlotMenu(Player* player, Creature* creature)
+    static constexpr const char* MENU_CACHE_KEY = "mod_reforging_menu_cache";
+
+    static constexpr size_t MENU_TEXT_LENGTH = 1024;
+
+    struct MenuLine
+    {
+        uint8 icon;
+        std::string text;
+        uint32 sender;
+        uint32 action;
+    };
+
+    // 按装备栏位生成的菜单, 装备或重铸变化(版本号/栏位上的物品)或配置重载后才重新生成
+    struct ReforgerMenuCache : public DataMap::Base
+    {
+        struct Menu
+        {
+            bool valid = false;
+            uint32 gearVersion = 0;
+            uint32 configVersion = 0;
+            std::array<ObjectGuid::LowType, EQUIPMENT_SLOT_END> items{};
+            std::vector<MenuLine> lines;
+        };
+
+        Menu slotMenu;
+        Menu removeMenu;
+    };
+
+    static bool IsMenuCurrent(Player* player, const ReforgerMenuCache::Menu& menu, uint32 gearVersion, uint32 configVersion)
+    {
+        if (!menu.valid || menu.gearVersion != gearVersion || menu.configVersion != configVersion)
+            return false;
+
+        for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
+        {
+            Item* item = sItemReforge->GetItemInSlot(player, slot);
+            if ((item ? item->GetGUID().GetCounter() : 0) != menu.items[slot])
+                return false;
+        }
+
+        return true;
+    }
+
+    bool SendMenu(Player* player, Creature* creature, ReforgerMenuCache::Menu& menu, void (*build)(Player*, std::vector<MenuLine>&))
     {
         ClearGossipMenuFor(player);
 
+        uint32 gearVersion = sItemReforge->GetGearVersion(player);
+        uint32 configVersion = sItemReforge->GetConfigVersion();
+        if (IsMenuCurrent(player, menu, gearVersion, configVersion))
+            sItemReforge->CountMenuBuild(true);
+        else
+        {
+            menu.lines.clear();
+            build(player, menu.lines);
+            for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
+            {
+                Item* item = sItemReforge->GetItemInSlot(player, slot);
+                menu.items[slot] = item ? item->GetGUID().GetCounter() : 0;
+            }
+            menu.gearVersion = gearVersion;
+            menu.configVersion = configVersion;
+            menu.valid = true;
+            sItemReforge->CountMenuBuild(false);
+        }
+
+        for (const MenuLine& line : menu.lines)
+            AddGossipItemFor(player, line.icon, line.text, line.sender, line.action);
+
+        SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
+        return true;
+    }
+
+    static void BuildEquipmentSlotMenu(Player* player, std::vector<MenuLine>& lines)
+    {
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
         const std::vector<uint32>& reforgeableStats = sItemReforge->GetReforgeableStats();
-        std::ostringstream oss;
-        oss << "每次" << sItemReforge->GetNeedMoney() / 10000 << "金,可重铸成属性: ";
-        bool hasStats = false;
+        ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
+        text.Append("每次").AppendNumber(sItemReforge->GetNeedMoney() / 10000).Append("金,可重铸成属性: ");
         for (uint32 i = 0; i < reforgeableStats.size(); i++)
         {
-            hasStats = true;
-            oss << sItemReforge->StatTypeToString(reforgeableStats[i]);
-            if (i < reforgeableStats.size() - 1)
-                oss << ", ";
+            if (i > 0)
+                text.Append(", ");
+            text.Append(sItemReforge->StatTypeToString(reforgeableStats[i], locale));
         }
-        if (!hasStats)
-            oss << ItemReforge::TextRed("无");
+        if (reforgeableStats.empty())
+            ItemReforge::AppendRed(text, "无");
 
-        AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, oss.str(), GOSSIP_SENDER_MAIN + 1, EQUIPMENT_SLOT_END);
+        lines.push_back({ GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN + 1, EQUIPMENT_SLOT_END });
 
         for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
         {
             Item* item = sItemReforge->GetItemInSlot(player, slot);
-            std::ostringstream oss;
-            oss << sItemReforge->GetSlotIcon(slot);
-            oss << sItemReforge->GetSlotName(slot);
+            text.Clear();
+            ItemReforge::AppendSlotIcon(text, slot);
+            text.Append(sItemReforge->GetSlotName(slot, locale)).Append(" [");
 
             if (item == nullptr)
-                oss << " [" << ItemReforge::TextRed("无物品") << "]";
+                ItemReforge::AppendRed(text, "无物品");
             else
             {
                 if (sItemReforge->IsAlreadyReforged(item))
-                    oss << " [" << ItemReforge::TextRed("已重铸") << "]";
+                    ItemReforge::AppendRed(text, "已重铸");
                 else if (!sItemReforge->IsReforgeable(player, item))
-                    oss << " [" << ItemReforge::TextRed("不可重铸") << "]";
+                    ItemReforge::AppendRed(text, "不可重铸");
                 else
-                    oss << " [" << ItemReforge::TextGreen("可重铸") << "]";
+                    ItemReforge::AppendGreen(text, "可重铸");
             }
+            text.Append(']');
 
-            AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, oss.str(), GOSSIP_SENDER_MAIN + 1, slot);
+            lines.push_back({ GOSSIP_ICON_MONEY_BAG, std::string(text.View()), GOSSIP_SENDER_MAIN + 1, slot });
         }
 
-        AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF);
+        lines.push_back({ GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF });
+    }
 
-        SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
-        return true;
+    bool AddEquipmentSlotMenu(Player* player, Creature* creature)
+    {
+        ReforgerMenuCache* cache = player->CustomData.GetDefault<ReforgerMenuCache>(MENU_CACHE_KEY);
+        return SendMenu(player, creature, cache->slotMenu, BuildEquipmentSlotMenu);
     }
 
     bool CanAdvanceWithReforging(Player* player, const Item* item) const
@@ -92,17 +168,23 @@ private:
     bool AddReforgingMenu(Player* player, Creature* creature)
     {
         ClearGossipMenuFor(player);
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
 
-        ObjectGuid itemGuid = itemMap[player->GetGUID().GetCounter()];
+        ObjectGuid itemGuid = sItemReforge->GetGossipSelection(player);
         Item* item = player->GetItemByGuid(itemGuid);
         if (!CanAdvanceWithReforging(player, item))
             return CloseGossip(player, false);
 
-        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, ItemReforge::ItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 2, GOSSIP_ACTION_INFO_DEF + 100);
+        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, *sItemReforge->GetItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 2, GOSSIP_ACTION_INFO_DEF + 100);
 
         std::vector<_ItemStat> itemStats = sItemReforge->LoadItemStatInfo(item, true);
+        ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
         for (const _ItemStat& stat : itemStats)
-            AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, "重铸 " + sItemReforge->StatTypeToString(stat.ItemStatType), GOSSIP_SENDER_MAIN + 2, stat.ItemStatType);
+        {
+            text.Clear();
+            text.Append("重铸 ").Append(sItemReforge->StatTypeToString(stat.ItemStatType, locale));
+            AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN + 2, stat.ItemStatType);
+        }
 
         AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 1);
 
@@ -113,13 +195,14 @@ private:
     bool AddReforgingStatsMenu(Player* player, Creature* creature, uint32 stat)
     {
         ClearGossipMenuFor(player);
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
 
-        ObjectGuid itemGuid = itemMap[player->GetGUID().GetCounter()];
+        ObjectGuid itemGuid = sItemReforge->GetGossipSelection(player);
         Item* item = player->GetItemByGuid(itemGuid);
         if (!CanAdvanceWithReforging(player, item))
             return CloseGossip(player, false);
 
-        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, ItemReforge::ItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 2, stat);
+        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, *sItemReforge->GetItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 2, stat);
 
         const std::vector<uint32>& reforgeableStats = sItemReforge->GetReforgeableStats();
         std::vector<_ItemStat> itemStats = sItemReforge->LoadItemStatInfo(item);
@@ -129,21 +212,32 @@ private:
 
         uint32 taken = sItemReforge->CalculateReforgePct(toReforgeStat->ItemStatValue);
         uint32 newVal = toReforgeStat->ItemStatValue - taken;
-        std::ostringstream oss;
-        oss << "将扣除 " << ItemReforge::TextRed(Acore::ToString((uint32)sItemReforge->GetPercentage()) + "% ") << sItemReforge->StatTypeToString(stat);
-        AddGossipItemFor(player, GOSSIP_ICON_CHAT, oss.str(), GOSSIP_SENDER_MAIN + 2, stat);
-
-        oss.str("");
-        oss << sItemReforge->StatTypeToString(stat) << " 重铸后: ";
-        oss << ItemReforge::TextRed(Acore::ToString(newVal)) << " (-" << Acore::ToString(taken) << ")";
-        AddGossipItemFor(player, GOSSIP_ICON_CHAT, oss.str(), GOSSIP_SENDER_MAIN + 2, stat);
+        ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
+        ReforgeTextBuffer<64> value;
+        value.AppendNumber(uint32(sItemReforge->GetPercentage())).Append("% ");
+        text.Append("将扣除 ");
+        ItemReforge::AppendRed(text, value.View());
+        text.Append(sItemReforge->StatTypeToString(stat, locale));
+        AddGossipItemFor(player, GOSSIP_ICON_CHAT, std::string(text.View()), GOSSIP_SENDER_MAIN + 2, stat);
+
+        text.Clear();
+        value.Clear();
+        value.AppendNumber(newVal);
+        text.Append(sItemReforge->StatTypeToString(stat, locale)).Append(" 重铸后: ");
+        ItemReforge::AppendRed(text, value.View());
+        text.Append(" (-").AppendNumber(taken).Append(')');
+        AddGossipItemFor(player, GOSSIP_ICON_CHAT, std::string(text.View()), GOSSIP_SENDER_MAIN + 2, stat);
 
         for (const uint32& rstat : reforgeableStats)
         {
             if (sItemReforge->FindItemStat(itemStats, rstat) != nullptr)
                 continue;
 
-            AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, ItemReforge::TextGreen("+" + Acore::ToString(taken) + " " + sItemReforge->StatTypeToString(rstat)), GOSSIP_SENDER_MAIN + 10 + stat, rstat, "确定要重铸该物品?", 0, false);
+            text.Clear();
+            value.Clear();
+            value.Append('+').AppendNumber(taken).Append(' ').Append(sItemReforge->StatTypeToString(rstat, locale));
+            ItemReforge::AppendGreen(text, value.View());
+            AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN + 10 + stat, rstat, "确定要重铸该物品?", 0, false);
         }
 
         AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN + 2, GOSSIP_ACTION_INFO_DEF + 100);
@@ -152,49 +246,54 @@ private:
         return true;
     }
 
-    bool AddRemoveReforgeMenu(Player* player, Creature* creature)
+    static void BuildRemoveReforgeMenu(Player* player, std::vector<MenuLine>& lines)
     {
-        ClearGossipMenuFor(player);
-
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
+        ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
         for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
         {
             Item* item = sItemReforge->GetItemInSlot(player, slot);
-            std::ostringstream oss;
-            oss << sItemReforge->GetSlotIcon(slot);
-            oss << sItemReforge->GetSlotName(slot);
+            text.Clear();
+            ItemReforge::AppendSlotIcon(text, slot);
+            text.Append(sItemReforge->GetSlotName(slot, locale)).Append(" [");
 
             if (item == nullptr)
-                oss << " [" << ItemReforge::TextRed("无物品") << "]";
+                ItemReforge::AppendRed(text, "无物品");
             else
             {
                 if (sItemReforge->IsAlreadyReforged(item))
-                    oss << " [" << ItemReforge::TextGreen("已重铸") << "]";
+                    ItemReforge::AppendGreen(text, "已重铸");
                 else
-                    oss << " [" << ItemReforge::TextRed("未重铸") << "]";
+                    ItemReforge::AppendRed(text, "未重铸");
             }
+            text.Append(']');
 
-            AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, oss.str(), GOSSIP_SENDER_MAIN + 3, slot);
+            lines.push_back({ GOSSIP_ICON_MONEY_BAG, std::string(text.View()), GOSSIP_SENDER_MAIN + 3, slot });
         }
 
-        AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF);
+        lines.push_back({ GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF });
+    }
 
-        SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
-        return true;
+    bool AddRemoveReforgeMenu(Player* player, Creature* creature)
+    {
+        ReforgerMenuCache* cache = player->CustomData.GetDefault<ReforgerMenuCache>(MENU_CACHE_KEY);
+        return SendMenu(player, creature, cache->removeMenu, BuildRemoveReforgeMenu);
     }
 
     bool AddRemoveReforgeStatsMenu(Player* player, Creature* creature)
     {
         ClearGossipMenuFor(player);
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
 
-        ObjectGuid itemGuid = itemMap[player->GetGUID().GetCounter()];
+        ObjectGuid itemGuid = sItemReforge->GetGossipSelection(player);
         Item* item = player->GetItemByGuid(itemGuid);
         if (!sItemReforge->CanRemoveReforge(item))
             return CloseGossip(player, false);
 
-        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, ItemReforge::ItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
+        AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, *sItemReforge->GetItemLinkForUI(item, player), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
 
-        const ItemReforge::ReforgingData* reforging = sItemReforge->GetReforgingData(item);
-        if (reforging == nullptr)
+        std::optional<ItemReforge::ReforgingData> reforging = sItemReforge->GetReforgingData(item);
+        if (!reforging)
             return CloseGossip(player, false);
 
         std::vector<_ItemStat> itemStats = sItemReforge->LoadItemStatInfo(item);
@@ -202,21 +301,93 @@ private:
         if (decreasedStat == nullptr)
             return CloseGossip(player, false);
 
-        std::ostringstream oss;
-        oss << "将恢复 " << sItemReforge->StatTypeToString(decreasedStat->ItemStatType) << " 为 " << ItemReforge::TextGreen(Acore::ToString(decreasedStat->ItemStatValue));
-        AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, oss.str(), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
+        ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
+        ReforgeTextBuffer<64> value;
+        value.AppendNumber(decreasedStat->ItemStatValue);
+        text.Append("将恢复 ").Append(sItemReforge->StatTypeToString(decreasedStat->ItemStatType, locale)).Append(" 为 ");
+        ItemReforge::AppendGreen(text, value.View());
+        AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
 
-        oss.str("");
-        oss << ItemReforge::TextRed("-" + Acore::ToString(reforging->stat_value) + " " + sItemReforge->StatTypeToString(reforging->stat_increase));
-        AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, oss.str(), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
+        text.Clear();
+        value.Clear();
+        value.Append('-').AppendNumber(reforging->stat_value).Append(' ').Append(sItemReforge->StatTypeToString(reforging->stat_increase, locale));
+        ItemReforge::AppendRed(text, value.View());
+        AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF);
 
-        AddGossipItemFor(player, GOSSIP_ICON_BATTLE, ItemReforge::TextRed("[恢复]"), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF + 1, "你确定吗?", 0, false);
+        text.Clear();
+        ItemReforge::AppendRed(text, "[恢复]");
+        AddGossipItemFor(player, GOSSIP_ICON_BATTLE, std::string(text.View()), GOSSIP_SENDER_MAIN + 4, GOSSIP_ACTION_INFO_DEF + 1, "你确定吗?", 0, false);
 
         AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 3);
 
         SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
         return true;
     }
+
+    bool AddSuggestionMenu(Player* player, Creature* creature)
+    {
+        ClearGossipMenuFor(player);
+        LocaleConstant locale = player->GetSession()->GetSessionDbLocaleIndex();
+
+        std::vector<ItemReforge::ReforgeSuggestion> suggestions;
+        sItemReforge->SuggestReforges(player, suggestions);
+        if (suggestions.empty())
+            AddGossipItemFor(player, GOSSIP_ICON_CHAT, "当前装备没有更好的重铸方案", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 4);
+        else
+        {
+            ReforgeTextBuffer<MENU_TEXT_LENGTH> text;
+            ReforgeTextBuffer<64> value;
+            for (const ItemReforge::ReforgeSuggestion& suggestion : suggestions)
+            {
+                text.Clear();
+                ItemReforge::AppendSlotIcon(text, suggestion.slot);
+                text.Append(sItemReforge->GetSlotName(suggestion.slot, locale)).Append(": ");
+                value.Clear();
+                value.Append('-').AppendNumber(suggestion.stat_value).Append(' ').Append(sItemReforge->StatTypeToString(suggestion.stat_decrease, locale));
+                ItemReforge::AppendRed(text, value.View());
+                text.Append(" ");
+                value.Clear();
+                value.Append('+').AppendNumber(suggestion.stat_value).Append(' ').Append(sItemReforge->StatTypeToString(suggestion.stat_increase, locale));
+                ItemReforge::AppendGreen(text, value.View());
+                AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, std::string(text.View()), GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 4);
+            }
+
+            text.Clear();
+            text.Append("按推荐方案重铸 ").AppendNumber(suggestions.size()).Append(" 件装备, 花费 ")
+                .AppendNumber(uint64(sItemReforge->GetNeedMoney()) * suggestions.size() / 10000).Append(" 金");
+            AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, std::string(text.View()), GOSSIP_SENDER_MAIN + 6, GOSSIP_ACTION_INFO_DEF, "确定要按推荐方案重铸吗?", 0, false);
+        }
+
+        AddGossipItemFor(player, GOSSIP_ICON_CHAT, "返回", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF);
+
+        SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
+        return true;
+    }
+
+    // 批量重铸编码: "槽位:减少属性:增加属性", 多项用逗号分隔, 例如 "4:31:32,6:36:37"
+    static bool ParseReforgeChoices(const std::string& code, std::vector<ItemReforge::ReforgeChoice>& choices)
+    {
+        for (std::string_view entry : Acore::Tokenize(code, ',', false))
+        {
+            std::vector<std::string_view> fields = Acore::Tokenize(entry, ':', false);
+            if (fields.size() != 3)
+                return false;
+
+            Optional<uint32> slot = Acore::StringTo<uint32>(fields[0]);
+            Optional<uint32> decrease = Acore::StringTo<uint32>(fields[1]);
+            Optional<uint32> increase = Acore::StringTo<uint32>(fields[2]);
+            if (!slot || !decrease || !increase || *slot >= EQUIPMENT_SLOT_END)
+                return false;
+
+            ItemReforge::ReforgeChoice choice;
+            choice.slot = uint8(*slot);
+            choice.stat_decrease = *decrease;
+            choice.stat_increase = *increase;
+            choices.push_back(choice);
+        }
+
+        return !choices.empty();
+    }
 public:
     npc_reforger() : CreatureScript("npc_reforger") {}
 
@@ -228,6 +399,9 @@ public:
         {
             AddGossipItemFor(player, GOSSIP_ICON_BATTLE, "选择重铸的槽位", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 1);
             AddGossipItemFor(player, GOSSIP_ICON_BATTLE, "从物品移除重铸", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 3);
+            AddGossipItemFor(player, GOSSIP_ICON_INTERACT_1, "推荐重铸方案", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 4);
+            AddGossipItemFor(player, GOSSIP_ICON_MONEY_BAG, "批量重铸多个槽位", GOSSIP_SENDER_MAIN + 5, GOSSIP_ACTION_INFO_DEF,
+                "输入 槽位:减少属性:增加属性, 多项用逗号分隔 (例如 4:31:32,6:36:37), 每项收费相同", 0, true);
         }
         AddGossipItemFor(player, GOSSIP_ICON_CHAT, "再见!", GOSSIP_SENDER_MAIN, GOSSIP_ACTION_INFO_DEF + 2);
         SendGossipMenuFor(player, DEFAULT_GOSSIP_MESSAGE, creature->GetGUID());
@@ -252,6 +426,8 @@ public:
                 return CloseGossip(player);
             else if (action == GOSSIP_ACTION_INFO_DEF + 3)
                 return AddRemoveReforgeMenu(player, creature);
+            else if (action == GOSSIP_ACTION_INFO_DEF + 4)
+                return AddSuggestionMenu(player, creature);
         }
         else if (sender == GOSSIP_SENDER_MAIN + 1)
         {
@@ -264,7 +440,7 @@ public:
                 return AddEquipmentSlotMenu(player, creature);
             else
             {
-                itemMap[player->GetGUID().GetCounter()] = item->GetGUID();
+                sItemReforge->SetGossipSelection(player, item->GetGUID());
                 return AddReforgingMenu(player, creature);
             }
         }
@@ -283,7 +459,7 @@ public:
                 return AddRemoveReforgeMenu(player, creature);
             else
             {
-                itemMap[player->GetGUID().GetCounter()] = item->GetGUID();
+                sItemReforge->SetGossipSelection(player, item->GetGUID());
                 return AddRemoveReforgeStatsMenu(player, creature);
             }
         }
@@ -293,17 +469,36 @@ public:
                 return AddRemoveReforgeStatsMenu(player, creature);
             else
             {
-                if (sItemReforge->RemoveReforge(player, itemMap[player->GetGUID().GetCounter()]))
+                if (sItemReforge->RemoveReforge(player, sItemReforge->GetGossipSelection(player)))
                     sItemReforge->VisualFeedback(player);
 
                 return CloseGossip(player);
             }
         }
+        else if (sender == GOSSIP_SENDER_MAIN + 6)
+        {
+            // 确认时重新计算, 菜单打开期间装备或配置可能已经变化
+            std::vector<ItemReforge::ReforgeSuggestion> suggestions;
+            sItemReforge->SuggestReforges(player, suggestions);
+
+            std::vector<ItemReforge::ReforgeChoice> choices;
+            for (const ItemReforge::ReforgeSuggestion& suggestion : suggestions)
+                choices.push_back({ suggestion.slot, suggestion.stat_decrease, suggestion.stat_increase });
+
+            if (choices.empty())
+                ItemReforge::SendMessage(player, "当前装备没有更好的重铸方案");
+            else if (sItemReforge->ReforgeBatch(player, choices))
+                sItemReforge->VisualFeedback(player);
+            else
+                ItemReforge::SendMessage(player, "重铸失败!请重试.");
+
+            return CloseGossip(player);
+        }
         else if (sender >= GOSSIP_SENDER_MAIN + 10)
         {
             uint32 decreaseStat = sender - (GOSSIP_SENDER_MAIN + 10);
             uint32 increaseStat = action;
-            if (!sItemReforge->Reforge(player, itemMap[player->GetGUID().GetCounter()], decreaseStat, increaseStat))
+            if (!sItemReforge->Reforge(player, sItemReforge->GetGossipSelection(player), decreaseStat, increaseStat))
                 ItemReforge::SendMessage(player, "重铸失败!请重试.");
             else
                 sItemReforge->VisualFeedback(player);
@@ -313,6 +508,22 @@ public:
 
         return CloseGossip(player, false);
     }
+
+    bool OnGossipSelectCode(Player* player, Creature* /*creature*/, uint32 sender, uint32 /*action*/, const char* code) override
+    {
+        if (!sItemReforge->GetEnabled() || sender != GOSSIP_SENDER_MAIN + 5)
+            return CloseGossip(player);
+
+        std::vector<ItemReforge::ReforgeChoice> choices;
+        if (!ParseReforgeChoices(code, choices))
+            ItemReforge::SendMessage(player, "批量重铸的格式不正确");
+        else if (sItemReforge->ReforgeBatch(player, choices))
+            sItemReforge->VisualFeedback(player);
+        else
+            ItemReforge::SendMessage(player, "重铸失败!请重试.");
+
+        return CloseGossip(player);
+    }
 };
 
 void AddSC_npc_reforger()
@@ -0,0 +1,363 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_addon.h"
+#include "Chat.h"
+#include "Creature.h"
+#include "Log.h"
+#include "Player.h"
+#include "Timer.h"
+#include "WorldPacket.h"
+#include "item_reforge.h"
+
+namespace
+{
+    constexpr char BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    int8 Base64Value(char c)
+    {
+        if (c >= 'A' && c <= 'Z')
+            return c - 'A';
+        if (c >= 'a' && c <= 'z')
+            return c - 'a' + 26;
+        if (c >= '0' && c <= '9')
+            return c - '0' + 52;
+        if (c == '+')
+            return 62;
+        if (c == '/')
+            return 63;
+        return -1;
+    }
+}
+
+ReforgeAddon::ReforgeAddon()
+{
+    enabled = true;
+    messagesReceived = 0;
+    messagesSent = 0;
+    commandsApplied = 0;
+    commandsRejected = 0;
+}
+
+ReforgeAddon::~ReforgeAddon() {}
+
+/*static*/ ReforgeAddon* ReforgeAddon::instance()
+{
+    static ReforgeAddon instance;
+    return &instance;
+}
+
+void ReforgeAddon::SetEnabled(bool value)
+{
+    enabled = value;
+}
+
+bool ReforgeAddon::GetEnabled() const
+{
+    return enabled;
+}
+
+/*static*/ void ReforgeAddon::Encode(const ByteBuffer& data, ReforgeTextWriter& writer)
+{
+    // 不带填充的 base64, 插件消息里不能出现 \0 和 '|'
+    const uint8* bytes = data.contents();
+    uint32 bits = 0;
+    uint8 bitCount = 0;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        bits = (bits << 8) | bytes[i];
+        bitCount += 8;
+        while (bitCount >= 6)
+        {
+            bitCount -= 6;
+            writer.Append(BASE64_CHARS[(bits >> bitCount) & 0x3F]);
+        }
+    }
+
+    if (bitCount > 0)
+        writer.Append(BASE64_CHARS[(bits << (6 - bitCount)) & 0x3F]);
+}
+
+/*static*/ bool ReforgeAddon::Decode(std::string_view text, ByteBuffer& data)
+{
+    if (text.size() % 4 == 1)
+        return false;
+
+    uint32 bits = 0;
+    uint8 bitCount = 0;
+    for (char c : text)
+    {
+        int8 value = Base64Value(c);
+        if (value < 0)
+            return false;
+
+        bits = (bits << 6) | uint32(value);
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            data << uint8((bits >> bitCount) & 0xFF);
+        }
+    }
+
+    return true;
+}
+
+bool ReforgeAddon::IsNearReforger(Player* player, uint64 npcGuid) const
+{
+    Creature* creature = player->GetNPCIfCanInteractWith(ObjectGuid(npcGuid), UNIT_NPC_FLAG_GOSSIP);
+    return creature && creature->GetScriptName() == REFORGER_SCRIPT_NAME;
+}
+
+void ReforgeAddon::Send(Player* player, char command, const ByteBuffer& data)
+{
+    ReforgeTextBuffer<MAX_MESSAGE_LENGTH> text;
+    text.Append(PREFIX).Append('\t').Append(command);
+    Encode(data, text);
+    if (text.IsTruncated())
+    {
+        LOG_ERROR("module", "mod_reforging: addon message {} for {} does not fit in {} bytes", command, player->GetName(), MAX_MESSAGE_LENGTH);
+        return;
+    }
+
+    WorldPacket packet;
+    ChatHandler::BuildChatPacket(packet, CHAT_MSG_WHISPER, LANG_ADDON, player, player, text.View());
+    player->SendDirectMessage(&packet);
+    ++messagesSent;
+}
+
+void ReforgeAddon::SendResult(Player* player, char command, Result result)
+{
+    ByteBuffer data(2);
+    data << uint8(command) << uint8(result);
+    Send(player, 'A', data);
+}
+
+bool ReforgeAddon::CanQuery(Player* player)
+{
+    QueryThrottle* throttle = player->CustomData.GetDefault<QueryThrottle>(QUERY_THROTTLE_KEY);
+    uint32 now = getMSTime();
+    if (throttle->lastQueryTime != 0 && getMSTimeDiff(throttle->lastQueryTime, now) < MIN_QUERY_INTERVAL_MS)
+        return false;
+
+    throttle->lastQueryTime = now;
+    return true;
+}
+
+void ReforgeAddon::SendState(Player* player)
+{
+    static_assert(ItemReforge::MAX_REFORGEABLE_STATS <= 16, "sourceMask is 16 bits wide");
+
+    const std::vector<uint32>& reforgeableStats = sItemReforge->GetReforgeableStats();
+
+    ByteBuffer data(176);
+    data << PROTOCOL_VERSION << uint8(sItemReforge->GetEnabled()) << uint8(sItemReforge->GetPercentage()) << uint32(sItemReforge->GetNeedMoney());
+    data << uint8(reforgeableStats.size());
+    for (uint32 stat : reforgeableStats)
+        data << uint8(stat);
+
+    size_t slotCountPos = data.wpos();
+    uint8 slotCount = 0;
+    data << uint8(0);
+
+    // 只发送已重铸或可以重铸的栏位, 其余栏位插件不需要
+    for (uint8 slot = EQUIPMENT_SLOT_START; slot < EQUIPMENT_SLOT_END; slot++)
+    {
+        Item* item = sItemReforge->GetItemInSlot(player, slot);
+        if (!item)
+            continue;
+
+        uint8 flags = 0;
+        uint8 decrease = 0;
+        uint8 increase = 0;
+        uint16 value = 0;
+        uint16 sourceMask = 0;
+        if (std::optional<ItemReforge::ReforgingData> reforging = sItemReforge->GetReforgingData(item))
+        {
+            flags |= SLOT_FLAG_REFORGED;
+            decrease = uint8(reforging->stat_decrease);
+            increase = uint8(reforging->stat_increase);
+            value = uint16(reforging->stat_value);
+        }
+        else if (sItemReforge->IsReforgeable(player, item))
+        {
+            flags |= SLOT_FLAG_REFORGEABLE;
+            std::vector<_ItemStat> itemStats = sItemReforge->LoadItemStatInfo(item, true);
+            for (size_t i = 0; i < reforgeableStats.size(); ++i)
+                if (sItemReforge->FindItemStat(itemStats, reforgeableStats[i]) != nullptr)
+                    sourceMask |= uint16(1 << i);
+        }
+        else
+            continue;
+
+        data << slot << flags << decrease << increase << value << sourceMask;
+        ++slotCount;
+    }
+
+    data.put<uint8>(slotCountPos, slotCount);
+    Send(player, 'S', data);
+}
+
+void ReforgeAddon::SendSuggestions(Player* player)
+{
+    std::vector<ItemReforge::ReforgeSuggestion> suggestions;
+    sItemReforge->SuggestReforges(player, suggestions);
+
+    ByteBuffer data(1 + suggestions.size() * 5);
+    data << uint8(suggestions.size());
+    for (const ItemReforge::ReforgeSuggestion& suggestion : suggestions)
+        data << suggestion.slot << uint8(suggestion.stat_decrease) << uint8(suggestion.stat_increase) << uint16(suggestion.stat_value);
+
+    Send(player, 'O', data);
+}
+
+ReforgeAddon::Result ReforgeAddon::HandleReforge(Player* player, ByteBuffer& data)
+{
+    if (data.size() != sizeof(uint64) + 3)
+        return RESULT_MALFORMED;
+
+    uint64 npcGuid = data.read<uint64>();
+    uint8 slot = data.read<uint8>();
+    uint8 decrease = data.read<uint8>();
+    uint8 increase = data.read<uint8>();
+    if (slot >= EQUIPMENT_SLOT_END)
+        return RESULT_MALFORMED;
+
+    if (!IsNearReforger(player, npcGuid))
+        return RESULT_NO_REFORGER;
+
+    Item* item = sItemReforge->GetItemInSlot(player, slot);
+    if (!item || !sItemReforge->Reforge(player, item->GetGUID(), decrease, increase))
+        return RESULT_FAILED;
+
+    sItemReforge->VisualFeedback(player);
+    return RESULT_OK;
+}
+
+ReforgeAddon::Result ReforgeAddon::HandleRemove(Player* player, ByteBuffer& data)
+{
+    if (data.size() != sizeof(uint64) + 1)
+        return RESULT_MALFORMED;
+
+    uint64 npcGuid = data.read<uint64>();
+    uint8 slot = data.read<uint8>();
+    if (slot >= EQUIPMENT_SLOT_END)
+        return RESULT_MALFORMED;
+
+    if (!IsNearReforger(player, npcGuid))
+        return RESULT_NO_REFORGER;
+
+    Item* item = sItemReforge->GetItemInSlot(player, slot);
+    if (!sItemReforge->CanRemoveReforge(item) || !sItemReforge->RemoveReforge(player, item))
+        return RESULT_FAILED;
+
+    sItemReforge->VisualFeedback(player);
+    return RESULT_OK;
+}
+
+ReforgeAddon::Result ReforgeAddon::HandleBatch(Player* player, ByteBuffer& data)
+{
+    if (data.size() < sizeof(uint64) + 1)
+        return RESULT_MALFORMED;
+
+    uint64 npcGuid = data.read<uint64>();
+    uint8 count = data.read<uint8>();
+    if (count == 0 || count > EQUIPMENT_SLOT_END || data.size() != sizeof(uint64) + 1 + count * 3)
+        return RESULT_MALFORMED;
+
+    std::vector<ItemReforge::ReforgeChoice> choices(count);
+    for (ItemReforge::ReforgeChoice& choice : choices)
+    {
+        choice.slot = data.read<uint8>();
+        choice.stat_decrease = data.read<uint8>();
+        choice.stat_increase = data.read<uint8>();
+    }
+
+    if (!IsNearReforger(player, npcGuid))
+        return RESULT_NO_REFORGER;
+
+    if (!sItemReforge->ReforgeBatch(player, choices))
+        return RESULT_FAILED;
+
+    sItemReforge->VisualFeedback(player);
+    return RESULT_OK;
+}
+
+bool ReforgeAddon::HandleMessage(Player* player, std::string_view message)
+{
+    if (!GetEnabled())
+        return false;
+
+    // 插件消息的格式是 "前缀\t内容"
+    if (message.size() < PREFIX.size() + 2 || message.substr(0, PREFIX.size()) != PREFIX || message[PREFIX.size()] != '\t')
+        return false;
+
+    ++messagesReceived;
+    char command = message[PREFIX.size() + 1];
+    if (command == 'Q' || command == 'O')
+    {
+        if (!CanQuery(player))
+            SendResult(player, command, RESULT_THROTTLED);
+        else if (command == 'Q')
+            SendState(player);
+        else if (!sItemReforge->GetEnabled())
+            SendResult(player, command, RESULT_DISABLED);
+        else
+            SendSuggestions(player);
+        return true;
+    }
+
+    ByteBuffer data;
+    Result result = RESULT_MALFORMED;
+    if (!sItemReforge->GetEnabled())
+        result = RESULT_DISABLED;
+    else if (Decode(message.substr(PREFIX.size() + 2), data))
+    {
+        switch (command)
+        {
+            case 'R':
+                result = HandleReforge(player, data);
+                break;
+            case 'X':
+                result = HandleRemove(player, data);
+                break;
+            case 'B':
+                result = HandleBatch(player, data);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (result == RESULT_OK)
+        ++commandsApplied;
+    else
+        ++commandsRejected;
+
+    SendResult(player, command, result);
+    if (result == RESULT_OK)
+        SendState(player);
+
+    return true;
+}
+
+uint64 ReforgeAddon::GetMessagesReceived() const
+{
+    return messagesReceived;
+}
+
+uint64 ReforgeAddon::GetMessagesSent() const
+{
+    return messagesSent;
+}
+
+uint64 ReforgeAddon::GetCommandsApplied() const
+{
+    return commandsApplied;
+}
+
+uint64 ReforgeAddon::GetCommandsRejected() const
+{
+    return commandsRejected;
+}
@@ -0,0 +1,107 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_ADDON_H_
+#define _REFORGE_ADDON_H_
+
+#include "Define.h"
+#include "ByteBuffer.h"
+#include "DataMap.h"
+#include "reforge_text.h"
+#include <atomic>
+#include <string_view>
+
+class Player;
+
+/*
+ * 客户端插件协议: 插件用 SendAddonMessage("RFG", 内容, "WHISPER", 自己) 发送请求,
+ * 服务器以同样方式回复. 内容是一个命令字符加上 base64 编码的小端二进制数据, 整条消息不超过 255 字节.
+ *
+ * 请求:
+ *   Q                                           查询状态
+ *   R npcGuid(u64) slot(u8) dec(u8) inc(u8)     重铸一个栏位
+ *   X npcGuid(u64) slot(u8)                     移除一个栏位的重铸
+ *   B npcGuid(u64) count(u8) {slot dec inc}*    批量重铸
+ *   O                                           查询推荐方案
+ * 回复:
+ *   S version(u8) enabled(u8) percentage(u8) cost(u32) statCount(u8) stats(u8)*
+ *     slotCount(u8) {slot(u8) flags(u8) dec(u8) inc(u8) value(u16) sourceMask(u16)}*
+ *     sourceMask 的第 i 位表示可重铸属性列表里第 i 个属性在该物品上, 其余列表属性即可选的目标属性
+ *   O count(u8) {slot(u8) dec(u8) inc(u8) value(u16)}*
+ *   A command(u8) result(u8)
+ *
+ * Q 和 O 每个玩家每秒最多一次, 过快的查询回复 A 和 RESULT_THROTTLED.
+ *
+ * 修改类请求必须带上玩家正在交互范围内的重铸师 GUID, 与对话菜单的距离校验一致.
+ */
+class ReforgeAddon
+{
+public:
+    enum Result : uint8
+    {
+        RESULT_OK = 0,
+        RESULT_FAILED = 1,
+        RESULT_NO_REFORGER = 2,
+        RESULT_MALFORMED = 3,
+        RESULT_DISABLED = 4,
+        RESULT_THROTTLED = 5
+    };
+
+    enum SlotFlags : uint8
+    {
+        SLOT_FLAG_REFORGED = 0x01,
+        SLOT_FLAG_REFORGEABLE = 0x02
+    };
+private:
+    static constexpr std::string_view PREFIX = "RFG";
+    static constexpr uint8 PROTOCOL_VERSION = 1;
+    // 客户端的插件消息上限 255 字节, 包含前缀和分隔符
+    static constexpr size_t MAX_MESSAGE_LENGTH = 254;
+    static constexpr const char* REFORGER_SCRIPT_NAME = "npc_reforger";
+    // Q 和 O 每次都要遍历装备(O 还要运行优化器), 每个玩家按最短间隔限速
+    static constexpr uint32 MIN_QUERY_INTERVAL_MS = 1000;
+    static constexpr const char* QUERY_THROTTLE_KEY = "mod_reforging_addon_query_throttle_key";
+
+    struct QueryThrottle : public DataMap::Base
+    {
+        uint32 lastQueryTime = 0;
+    };
+
+    bool enabled;
+    std::atomic<uint64> messagesReceived;
+    std::atomic<uint64> messagesSent;
+    std::atomic<uint64> commandsApplied;
+    std::atomic<uint64> commandsRejected;
+
+    ReforgeAddon();
+    ~ReforgeAddon();
+
+    static void Encode(const ByteBuffer& data, ReforgeTextWriter& writer);
+    static bool Decode(std::string_view text, ByteBuffer& data);
+    bool IsNearReforger(Player* player, uint64 npcGuid) const;
+    void Send(Player* player, char command, const ByteBuffer& data);
+    void SendResult(Player* player, char command, Result result);
+    bool CanQuery(Player* player);
+    Result HandleReforge(Player* player, ByteBuffer& data);
+    Result HandleRemove(Player* player, ByteBuffer& data);
+    Result HandleBatch(Player* player, ByteBuffer& data);
+public:
+    static ReforgeAddon* instance();
+
+    void SetEnabled(bool value);
+    bool GetEnabled() const;
+
+    bool HandleMessage(Player* player, std::string_view message);
+    void SendState(Player* player);
+    void SendSuggestions(Player* player);
+
+    uint64 GetMessagesReceived() const;
+    uint64 GetMessagesSent() const;
+    uint64 GetCommandsApplied() const;
+    uint64 GetCommandsRejected() const;
+};
+
+#define sReforgeAddon ReforgeAddon::instance()
+
+#endif
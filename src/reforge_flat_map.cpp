@@ -0,0 +1,200 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_flat_map.h"
+
+ReforgeFlatMap::ReforgeFlatMap()
+{
+    count = 0;
+    mask = 0;
+}
+
+/*static*/ size_t ReforgeFlatMap::Hash(uint32 key)
+{
+    // murmur3 fmix32, item_guid 大多连续, 需要打散后再取低位
+    key ^= key >> 16;
+    key *= 0x85ebca6b;
+    key ^= key >> 13;
+    key *= 0xc2b2ae35;
+    key ^= key >> 16;
+    return key;
+}
+
+size_t ReforgeFlatMap::FindSlot(uint32 itemGuid) const
+{
+    if (records.empty() || itemGuid == 0)
+        return records.size();
+
+    for (size_t i = Hash(itemGuid) & mask; ; i = (i + 1) & mask)
+    {
+        if (records[i].item_guid == itemGuid)
+            return i;
+        if (records[i].item_guid == 0)
+            return records.size();
+    }
+}
+
+void ReforgeFlatMap::Rehash(size_t newCapacity)
+{
+    std::vector<Record> oldRecords(newCapacity, Record{ 0, 0, 0, 0 });
+    std::vector<uint32> oldOwners(newCapacity, 0);
+    oldRecords.swap(records);
+    oldOwners.swap(owners);
+    mask = newCapacity - 1;
+
+    for (size_t i = 0; i < oldRecords.size(); i++)
+    {
+        if (oldRecords[i].item_guid == 0)
+            continue;
+
+        size_t slot = Hash(oldRecords[i].item_guid) & mask;
+        while (records[slot].item_guid != 0)
+            slot = (slot + 1) & mask;
+
+        records[slot] = oldRecords[i];
+        owners[slot] = oldOwners[i];
+    }
+}
+
+const ReforgeFlatMap::Record* ReforgeFlatMap::Find(uint32 itemGuid, uint32* owner) const
+{
+    size_t slot = FindSlot(itemGuid);
+    if (slot == records.size())
+        return nullptr;
+
+    if (owner)
+        *owner = owners[slot];
+    return &records[slot];
+}
+
+bool ReforgeFlatMap::Contains(uint32 itemGuid) const
+{
+    return FindSlot(itemGuid) != records.size();
+}
+
+void ReforgeFlatMap::Insert(uint32 itemGuid, uint32 owner, uint8 statDecrease, uint8 statIncrease, uint16 statValue)
+{
+    if (itemGuid == 0)
+        return;
+
+    // 负载因子保持在 3/4 以下
+    if ((count + 1) * 4 > records.size() * 3)
+        Rehash(records.empty() ? MIN_CAPACITY : records.size() * 2);
+
+    size_t slot = Hash(itemGuid) & mask;
+    while (records[slot].item_guid != 0 && records[slot].item_guid != itemGuid)
+        slot = (slot + 1) & mask;
+
+    if (records[slot].item_guid == 0)
+        ++count;
+
+    records[slot] = Record{ itemGuid, statValue, statDecrease, statIncrease };
+    owners[slot] = owner;
+}
+
+bool ReforgeFlatMap::Erase(uint32 itemGuid)
+{
+    size_t hole = FindSlot(itemGuid);
+    if (hole == records.size())
+        return false;
+
+    // 后移删除: 把后面探测链上的记录前移填洞, 直到遇到空槽
+    for (size_t next = (hole + 1) & mask; records[next].item_guid != 0; next = (next + 1) & mask)
+    {
+        size_t home = Hash(records[next].item_guid) & mask;
+        bool canMove = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (!canMove)
+            continue;
+
+        records[hole] = records[next];
+        owners[hole] = owners[next];
+        hole = next;
+    }
+
+    records[hole] = Record{ 0, 0, 0, 0 };
+    owners[hole] = 0;
+    --count;
+    return true;
+}
+
+void ReforgeFlatMap::Reserve(size_t entries)
+{
+    size_t capacity = MIN_CAPACITY;
+    while (capacity * 3 < entries * 4)
+        capacity *= 2;
+
+    if (capacity > records.size())
+        Rehash(capacity);
+}
+
+void ReforgeFlatMap::Shrink()
+{
+    if (count == 0)
+    {
+        Clear();
+        return;
+    }
+
+    size_t capacity = MIN_CAPACITY;
+    while (capacity * 3 < count * 4)
+        capacity *= 2;
+
+    if (capacity < records.size())
+        Rehash(capacity);
+}
+
+void ReforgeFlatMap::Clear()
+{
+    std::vector<Record>().swap(records);
+    std::vector<uint32>().swap(owners);
+    count = 0;
+    mask = 0;
+}
+
+bool ReforgeFlatMap::Assign(std::vector<Record>&& newRecords, std::vector<uint32>&& newOwners)
+{
+    // 直接接管快照里的原始槽位数组, 槽位布局与本类的哈希一致, 不需要重新插入
+    size_t capacity = newRecords.size();
+    if (capacity < MIN_CAPACITY || (capacity & (capacity - 1)) != 0 || newOwners.size() != capacity)
+        return false;
+
+    size_t used = 0;
+    for (const Record& record : newRecords)
+        if (record.item_guid != 0)
+            ++used;
+
+    if (used * 4 > capacity * 3)
+        return false;
+
+    records = std::move(newRecords);
+    owners = std::move(newOwners);
+    count = used;
+    mask = capacity - 1;
+    return true;
+}
+
+const std::vector<ReforgeFlatMap::Record>& ReforgeFlatMap::GetRecords() const
+{
+    return records;
+}
+
+const std::vector<uint32>& ReforgeFlatMap::GetOwners() const
+{
+    return owners;
+}
+
+size_t ReforgeFlatMap::Size() const
+{
+    return count;
+}
+
+size_t ReforgeFlatMap::Capacity() const
+{
+    return records.size();
+}
+
+size_t ReforgeFlatMap::MemoryUsage() const
+{
+    return records.capacity() * sizeof(Record) + owners.capacity() * sizeof(uint32);
+}
@@ -0,0 +1,69 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_FLAT_MAP_H_
+#define _REFORGE_FLAT_MAP_H_
+
+#include "Define.h"
+#include <vector>
+
+/*
+ * 开放寻址(线性探测)的重铸数据表, 以 item_guid 为键.
+ * 每条记录 8 字节, 属性类型用 uint8, 数值用 uint16, 拥有者 guid 单独存放在并行数组里,
+ * 查找时只访问记录数组. item_guid 为 0 表示空槽, 删除使用后移法, 不留墓碑.
+ */
+class ReforgeFlatMap
+{
+public:
+    struct Record
+    {
+        uint32 item_guid;
+        uint16 stat_value;
+        uint8 stat_decrease;
+        uint8 stat_increase;
+    };
+    static_assert(sizeof(Record) == 8, "ReforgeFlatMap::Record must stay packed");
+
+    static constexpr uint32 MAX_STAT_TYPE = 0xFF;
+    static constexpr uint32 MAX_STAT_VALUE = 0xFFFF;
+private:
+    static constexpr size_t MIN_CAPACITY = 16;
+
+    std::vector<Record> records;
+    std::vector<uint32> owners;
+    size_t count;
+    size_t mask;
+
+    static size_t Hash(uint32 key);
+    size_t FindSlot(uint32 itemGuid) const;
+    void Rehash(size_t newCapacity);
+public:
+    ReforgeFlatMap();
+
+    const Record* Find(uint32 itemGuid, uint32* owner = nullptr) const;
+    bool Contains(uint32 itemGuid) const;
+    void Insert(uint32 itemGuid, uint32 owner, uint8 statDecrease, uint8 statIncrease, uint16 statValue);
+    bool Erase(uint32 itemGuid);
+    void Reserve(size_t entries);
+    void Shrink();
+    void Clear();
+    bool Assign(std::vector<Record>&& newRecords, std::vector<uint32>&& newOwners);
+
+    const std::vector<Record>& GetRecords() const;
+    const std::vector<uint32>& GetOwners() const;
+
+    size_t Size() const;
+    size_t Capacity() const;
+    size_t MemoryUsage() const;
+
+    template<typename Visitor>
+    void ForEach(Visitor&& visitor) const
+    {
+        for (size_t i = 0; i < records.size(); i++)
+            if (records[i].item_guid != 0)
+                visitor(records[i], owners[i]);
+    }
+};
+
+#endif
@@ -0,0 +1,134 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_login_queue.h"
+#include "ObjectAccessor.h"
+#include "Player.h"
+#include "Timer.h"
+#include "item_reforge.h"
+
+ReforgeLoginQueue::ReforgeLoginQueue()
+{
+    readyTimeout = READY_TIMEOUT_MS_DEFAULT;
+    packetsPerTick = PACKETS_PER_TICK_DEFAULT;
+    readyByClient = 0;
+    readyByTimeout = 0;
+    packetsSent = 0;
+    lastReadyDelay = 0;
+}
+
+ReforgeLoginQueue::~ReforgeLoginQueue() {}
+
+/*static*/ ReforgeLoginQueue* ReforgeLoginQueue::instance()
+{
+    static ReforgeLoginQueue instance;
+    return &instance;
+}
+
+void ReforgeLoginQueue::SetReadyTimeout(uint32 value)
+{
+    readyTimeout = value > 0 ? value : READY_TIMEOUT_MS_DEFAULT;
+}
+
+void ReforgeLoginQueue::SetPacketsPerTick(uint32 value)
+{
+    packetsPerTick = value > 0 ? value : PACKETS_PER_TICK_DEFAULT;
+}
+
+void ReforgeLoginQueue::HandleLogin(uint32 guid)
+{
+    PendingLogin login;
+    login.loginTime = getMSTime();
+    login.ready = false;
+
+    std::lock_guard<std::mutex> guard(pendingLock);
+    pending[guid] = login;
+}
+
+void ReforgeLoginQueue::HandleLogout(uint32 guid)
+{
+    // 已经进入队列的角色在 Update 里找不到 Player, 直接跳过
+    std::lock_guard<std::mutex> guard(pendingLock);
+    pending.erase(guid);
+}
+
+void ReforgeLoginQueue::HandleClientReady(uint32 guid)
+{
+    // 传送和载具也会发送 CMSG_SET_ACTIVE_MOVER, 只处理刚登录的角色
+    std::lock_guard<std::mutex> guard(pendingLock);
+    PendingLoginContainer::iterator itr = pending.find(guid);
+    if (itr != pending.end())
+        itr->second.ready = true;
+}
+
+void ReforgeLoginQueue::Update()
+{
+    {
+        std::lock_guard<std::mutex> guard(pendingLock);
+        for (PendingLoginContainer::iterator itr = pending.begin(); itr != pending.end(); )
+        {
+            uint32 delay = GetMSTimeDiffToNow(itr->second.loginTime);
+            if (itr->second.ready)
+                ++readyByClient;
+            else if (delay >= readyTimeout)
+                ++readyByTimeout;
+            else
+            {
+                ++itr;
+                continue;
+            }
+
+            lastReadyDelay = delay;
+            queue.push_back(itr->first);
+            itr = pending.erase(itr);
+        }
+    }
+
+    // 预算按包计算, 一个角色的包总是一次发完
+    uint32 sent = 0;
+    while (!queue.empty() && sent < packetsPerTick)
+    {
+        uint32 guid = queue.front();
+        queue.pop_front();
+
+        Player* player = ObjectAccessor::FindPlayerByLowGUID(guid);
+        if (!player || !player->IsInWorld())
+            continue;
+
+        sent += sItemReforge->SendReforgedItemPackets(player);
+    }
+
+    packetsSent += sent;
+}
+
+uint32 ReforgeLoginQueue::GetPendingCount()
+{
+    std::lock_guard<std::mutex> guard(pendingLock);
+    return pending.size();
+}
+
+uint32 ReforgeLoginQueue::GetQueuedCount() const
+{
+    return queue.size();
+}
+
+uint64 ReforgeLoginQueue::GetReadyByClientCount() const
+{
+    return readyByClient;
+}
+
+uint64 ReforgeLoginQueue::GetReadyByTimeoutCount() const
+{
+    return readyByTimeout;
+}
+
+uint64 ReforgeLoginQueue::GetPacketsSent() const
+{
+    return packetsSent;
+}
+
+uint32 ReforgeLoginQueue::GetLastReadyDelay() const
+{
+    return lastReadyDelay;
+}
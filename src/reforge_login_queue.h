@@ -0,0 +1,69 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_LOGIN_QUEUE_H_
+#define _REFORGE_LOGIN_QUEUE_H_
+
+#include "Define.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+/*
+ * 登录后推送重铸物品的查询结果: 客户端进入世界(发送 CMSG_SET_ACTIVE_MOVER)即视为就绪,
+ * 超时仍未就绪的按超时处理. 就绪的角色进入队列, 每个世界 tick 只发送有限数量的包,
+ * 大量角色同时重连时推送会分摊到后续的 tick.
+ */
+class ReforgeLoginQueue
+{
+private:
+    static constexpr uint32 READY_TIMEOUT_MS_DEFAULT = 5000;
+    static constexpr uint32 PACKETS_PER_TICK_DEFAULT = 500;
+
+    struct PendingLogin
+    {
+        uint32 loginTime;
+        bool ready;
+    };
+
+    typedef std::unordered_map<uint32, PendingLogin> PendingLoginContainer;
+
+    uint32 readyTimeout;
+    uint32 packetsPerTick;
+
+    // 就绪标记来自网络线程, 其余都在世界线程
+    std::mutex pendingLock;
+    PendingLoginContainer pending;
+    std::deque<uint32> queue;
+
+    std::atomic<uint64> readyByClient;
+    std::atomic<uint64> readyByTimeout;
+    std::atomic<uint64> packetsSent;
+    std::atomic<uint32> lastReadyDelay;
+
+    ReforgeLoginQueue();
+    ~ReforgeLoginQueue();
+public:
+    static ReforgeLoginQueue* instance();
+
+    void SetReadyTimeout(uint32 value);
+    void SetPacketsPerTick(uint32 value);
+
+    void HandleLogin(uint32 guid);
+    void HandleLogout(uint32 guid);
+    void HandleClientReady(uint32 guid);
+    void Update();
+
+    uint32 GetPendingCount();
+    uint32 GetQueuedCount() const;
+    uint64 GetReadyByClientCount() const;
+    uint64 GetReadyByTimeoutCount() const;
+    uint64 GetPacketsSent() const;
+    uint32 GetLastReadyDelay() const;
+};
+
+#define sReforgeLoginQueue ReforgeLoginQueue::instance()
+
+#endif
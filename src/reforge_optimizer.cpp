@@ -0,0 +1,106 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_optimizer.h"
+#include <algorithm>
+
+ReforgeOptimizer::ReforgeOptimizer(uint32 count)
+{
+    statCount = std::min(count, MAX_STATS);
+    weights.fill(0.0f);
+    base.fill(0);
+    caps.fill(0);
+    delta.fill(0);
+}
+
+void ReforgeOptimizer::SetStat(uint32 stat, float weight, int32 statBase, int32 cap)
+{
+    if (stat >= statCount)
+        return;
+
+    weights[stat] = weight;
+    base[stat] = statBase;
+    caps[stat] = cap;
+}
+
+void ReforgeOptimizer::AddSlot(Slot&& slot)
+{
+    slot.chosen = -1;
+    slots.push_back(std::move(slot));
+}
+
+// 属性变化 change 时的加权收益, 超过上限的部分不计
+float ReforgeOptimizer::Gain(uint32 stat, int32 change) const
+{
+    if (!caps[stat])
+        return weights[stat] * change;
+
+    return weights[stat] * (std::min(base[stat] + change, caps[stat]) - std::min(base[stat], caps[stat]));
+}
+
+float ReforgeOptimizer::OptionGain(const Option& option) const
+{
+    return Gain(option.decrease, delta[option.decrease] - option.value) - Gain(option.decrease, delta[option.decrease])
+        + Gain(option.increase, delta[option.increase] + option.value) - Gain(option.increase, delta[option.increase]);
+}
+
+void ReforgeOptimizer::Apply(const Option& option, int32 sign)
+{
+    delta[option.decrease] -= sign * option.value;
+    delta[option.increase] += sign * option.value;
+}
+
+float ReforgeOptimizer::Solve()
+{
+    for (uint32 pass = 0; pass < MAX_PASSES; ++pass)
+    {
+        bool changed = false;
+        for (Slot& slot : slots)
+        {
+            float bestGain = 0.0f;
+            int32 best = -1;
+            if (slot.chosen >= 0)
+            {
+                Apply(slot.options[slot.chosen], -1);
+                float current = OptionGain(slot.options[slot.chosen]);
+                if (current > EPSILON)
+                {
+                    bestGain = current;
+                    best = slot.chosen;
+                }
+            }
+
+            for (size_t i = 0; i < slot.options.size(); ++i)
+            {
+                float optionValue = OptionGain(slot.options[i]);
+                if (optionValue > bestGain + EPSILON)
+                {
+                    bestGain = optionValue;
+                    best = int32(i);
+                }
+            }
+
+            if (best >= 0)
+                Apply(slot.options[best], 1);
+            if (best != slot.chosen)
+            {
+                slot.chosen = best;
+                changed = true;
+            }
+        }
+
+        if (!changed)
+            break;
+    }
+
+    float total = 0.0f;
+    for (uint32 i = 0; i < statCount; ++i)
+        total += Gain(i, delta[i]);
+    return total;
+}
+
+const std::vector<ReforgeOptimizer::Slot>& ReforgeOptimizer::GetSlots() const
+{
+    return slots;
+}
@@ -0,0 +1,62 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_OPTIMIZER_H_
+#define _REFORGE_OPTIMIZER_H_
+
+#include "Define.h"
+#include <array>
+#include <vector>
+
+/*
+ * 重铸推荐的局部搜索, 不依赖角色和物品对象, 候选项由 ItemReforge::SuggestReforges 填入.
+ * 属性按在可重铸属性列表里的位置编号. 每轮在其他栏位不变的前提下为每个栏位
+ * 重新选最好的一项(或不重铸), 直到一轮没有变化或达到 MAX_PASSES.
+ */
+class ReforgeOptimizer
+{
+public:
+    static constexpr uint32 MAX_STATS = 16;
+    static constexpr uint32 MAX_PASSES = 8;
+
+    struct Option
+    {
+        uint8 decrease;
+        uint8 increase;
+        int32 value;
+    };
+
+    struct Slot
+    {
+        uint8 slot;
+        // 选中的候选项下标, -1 表示不重铸
+        int32 chosen;
+        std::vector<Option> options;
+    };
+private:
+    static constexpr float EPSILON = 0.0001f;
+
+    uint32 statCount;
+    std::array<float, MAX_STATS> weights;
+    std::array<int32, MAX_STATS> base;
+    std::array<int32, MAX_STATS> caps;
+    std::array<int32, MAX_STATS> delta;
+    std::vector<Slot> slots;
+
+    float Gain(uint32 stat, int32 change) const;
+    float OptionGain(const Option& option) const;
+    void Apply(const Option& option, int32 sign);
+public:
+    explicit ReforgeOptimizer(uint32 count);
+
+    // cap 为 0 表示不设上限, 有上限的属性从 base 算起
+    void SetStat(uint32 stat, float weight, int32 statBase, int32 cap);
+    void AddSlot(Slot&& slot);
+    // 返回选中方案的总加权收益
+    float Solve();
+
+    const std::vector<Slot>& GetSlots() const;
+};
+
+#endif
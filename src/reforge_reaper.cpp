@@ -0,0 +1,231 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_reaper.h"
+#include "Log.h"
+#include "ObjectAccessor.h"
+#include "StringFormat.h"
+#include "Timer.h"
+#include "reforge_store.h"
+
+/*
+ * 孤立重铸记录清理：世界开放后按 item_guid 分批扫描 character_reforging,
+ * 用 LEFT JOIN 找出物品或角色已不存在的记录. 每批行数和每秒批数都有上限,
+ * 查询在数据库工作线程执行, 删除通过重铸写入队列提交.
+ */
+
+ReforgeReaper::ReforgeReaper()
+{
+    enabled = true;
+    dryRunConfig = false;
+    rowsPerBatch = ROWS_PER_BATCH_DEFAULT;
+    batchesPerSecond = BATCHES_PER_SECOND_DEFAULT;
+    state = State::IDLE;
+    dryRun = false;
+    queryInFlight = false;
+    batchTimer = 0;
+    cursor = 0;
+    batches = 0;
+    scannedRows = 0;
+    orphansFound = 0;
+    orphansRemoved = 0;
+    orphansSkipped = 0;
+    passStartTime = 0;
+    passDuration = 0;
+}
+
+ReforgeReaper::~ReforgeReaper() {}
+
+/*static*/ ReforgeReaper* ReforgeReaper::instance()
+{
+    static ReforgeReaper instance;
+    return &instance;
+}
+
+void ReforgeReaper::SetEnabled(bool value)
+{
+    enabled = value;
+}
+
+bool ReforgeReaper::GetEnabled() const
+{
+    return enabled;
+}
+
+void ReforgeReaper::SetDryRun(bool value)
+{
+    dryRunConfig = value;
+}
+
+void ReforgeReaper::SetRowsPerBatch(uint32 value)
+{
+    rowsPerBatch = value > 0 ? value : ROWS_PER_BATCH_DEFAULT;
+}
+
+void ReforgeReaper::SetBatchesPerSecond(uint32 value)
+{
+    batchesPerSecond = value > 0 ? value : BATCHES_PER_SECOND_DEFAULT;
+}
+
+void ReforgeReaper::Start()
+{
+    if (GetEnabled())
+        StartPass(dryRunConfig);
+}
+
+bool ReforgeReaper::StartPass(bool dry)
+{
+    if (state == State::RUNNING)
+        return false;
+
+    state = State::RUNNING;
+    dryRun = dry;
+    batchTimer = 0;
+    cursor = 0;
+    batches = 0;
+    scannedRows = 0;
+    orphansFound = 0;
+    orphansRemoved = 0;
+    orphansSkipped = 0;
+    passDuration = 0;
+    passStartTime = getMSTime();
+
+    LOG_INFO("module", "mod_reforging: orphan reaper started{} ({} rows per batch, {} batches per second)", dry ? " in dry-run mode" : "", rowsPerBatch, batchesPerSecond);
+    return true;
+}
+
+void ReforgeReaper::QueryNextBatch()
+{
+    queryInFlight = true;
+    callbacks.AddCallback(CharacterDatabase.AsyncQuery(Acore::StringFormat(
+        "SELECT cr.item_guid, cr.guid, ii.guid, c.guid FROM "
+        "(SELECT guid, item_guid FROM character_reforging WHERE item_guid > {} ORDER BY item_guid LIMIT {}) cr "
+        "LEFT JOIN item_instance ii ON ii.guid = cr.item_guid "
+        "LEFT JOIN characters c ON c.guid = cr.guid", uint32(cursor), rowsPerBatch))
+        .WithCallback([this](QueryResult result) { HandleBatch(result); }));
+}
+
+void ReforgeReaper::HandleBatch(QueryResult result)
+{
+    queryInFlight = false;
+    ++batches;
+
+    if (!result)
+    {
+        FinishPass();
+        return;
+    }
+
+    uint32 rows = 0;
+    uint32 lastItemGuid = cursor;
+    do
+    {
+        Field* fields = result->Fetch();
+        uint32 itemGuid = fields[0].Get<uint32>();
+        uint32 guid = fields[1].Get<uint32>();
+        bool itemMissing = fields[2].IsNull();
+        bool characterMissing = fields[3].IsNull();
+
+        ++rows;
+        if (itemGuid > lastItemGuid)
+            lastItemGuid = itemGuid;
+
+        if (!itemMissing && !characterMissing)
+            continue;
+
+        // 在线角色新重铸的物品可能还没存盘, item_instance 里暂时没有记录
+        if (!characterMissing && ObjectAccessor::FindPlayerByLowGUID(guid))
+        {
+            ++orphansSkipped;
+            continue;
+        }
+
+        ++orphansFound;
+        if (dryRun)
+            continue;
+
+        sReforgeStore->Remove(itemGuid, guid);
+        ++orphansRemoved;
+    } while (result->NextRow());
+
+    scannedRows += rows;
+    cursor = lastItemGuid;
+
+    if (rows < rowsPerBatch)
+        FinishPass();
+}
+
+void ReforgeReaper::FinishPass()
+{
+    state = State::FINISHED;
+    passDuration = GetMSTimeDiffToNow(passStartTime);
+
+    LOG_INFO("module", "mod_reforging: orphan reaper {} after {} ms: {} rows scanned in {} batches, {} orphans found, {} removed, {} skipped (owner online)",
+        dryRun ? "dry run finished" : "finished", uint32(passDuration), uint64(scannedRows), uint64(batches), uint64(orphansFound), uint64(orphansRemoved), uint64(orphansSkipped));
+}
+
+void ReforgeReaper::Update(uint32 diff)
+{
+    callbacks.ProcessReadyCallbacks();
+
+    if (state != State::RUNNING || queryInFlight)
+        return;
+
+    if (batchTimer > diff)
+    {
+        batchTimer -= diff;
+        return;
+    }
+
+    batchTimer = IN_MILLISECONDS / batchesPerSecond;
+    QueryNextBatch();
+}
+
+ReforgeReaper::State ReforgeReaper::GetState() const
+{
+    return state;
+}
+
+bool ReforgeReaper::IsDryRun() const
+{
+    return dryRun;
+}
+
+uint32 ReforgeReaper::GetCursor() const
+{
+    return cursor;
+}
+
+uint64 ReforgeReaper::GetBatchCount() const
+{
+    return batches;
+}
+
+uint64 ReforgeReaper::GetScannedRowCount() const
+{
+    return scannedRows;
+}
+
+uint64 ReforgeReaper::GetOrphansFound() const
+{
+    return orphansFound;
+}
+
+uint64 ReforgeReaper::GetOrphansRemoved() const
+{
+    return orphansRemoved;
+}
+
+uint64 ReforgeReaper::GetOrphansSkipped() const
+{
+    return orphansSkipped;
+}
+
+uint32 ReforgeReaper::GetPassDuration() const
+{
+    if (state == State::RUNNING)
+        return GetMSTimeDiffToNow(passStartTime);
+
+    return passDuration;
+}
@@ -0,0 +1,78 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_REAPER_H_
+#define _REFORGE_REAPER_H_
+
+#include "Define.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include <atomic>
+
+class ReforgeReaper
+{
+public:
+    enum class State : uint8
+    {
+        IDLE,
+        RUNNING,
+        FINISHED
+    };
+private:
+    static constexpr uint32 ROWS_PER_BATCH_DEFAULT = 1000;
+    static constexpr uint32 BATCHES_PER_SECOND_DEFAULT = 2;
+
+    bool enabled;
+    bool dryRunConfig;
+    uint32 rowsPerBatch;
+    uint32 batchesPerSecond;
+
+    std::atomic<State> state;
+    std::atomic<bool> dryRun;
+    bool queryInFlight;
+    uint32 batchTimer;
+    AsyncCallbackProcessor<QueryCallback> callbacks;
+
+    std::atomic<uint32> cursor;
+    std::atomic<uint64> batches;
+    std::atomic<uint64> scannedRows;
+    std::atomic<uint64> orphansFound;
+    std::atomic<uint64> orphansRemoved;
+    std::atomic<uint64> orphansSkipped;
+    uint32 passStartTime;
+    std::atomic<uint32> passDuration;
+
+    ReforgeReaper();
+    ~ReforgeReaper();
+
+    void QueryNextBatch();
+    void HandleBatch(QueryResult result);
+    void FinishPass();
+public:
+    static ReforgeReaper* instance();
+
+    void SetEnabled(bool value);
+    bool GetEnabled() const;
+    void SetDryRun(bool value);
+    void SetRowsPerBatch(uint32 value);
+    void SetBatchesPerSecond(uint32 value);
+
+    void Start();
+    bool StartPass(bool dry);
+    void Update(uint32 diff);
+
+    State GetState() const;
+    bool IsDryRun() const;
+    uint32 GetCursor() const;
+    uint64 GetBatchCount() const;
+    uint64 GetScannedRowCount() const;
+    uint64 GetOrphansFound() const;
+    uint64 GetOrphansRemoved() const;
+    uint64 GetOrphansSkipped() const;
+    uint32 GetPassDuration() const;
+};
+
+#define sReforgeReaper ReforgeReaper::instance()
+
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_reload_job.h"
+#include "Log.h"
+#include "ObjectAccessor.h"
+#include "Player.h"
+#include "Timer.h"
+#include "WorldSession.h"
+#include "WorldSessionMgr.h"
+#include "item_reforge.h"
+
+ReforgeReloadJob::ReforgeReloadJob()
+{
+    playersPerTick = PLAYERS_PER_TICK_DEFAULT;
+    startRequested = false;
+    state = State::IDLE;
+    position = 0;
+    total = 0;
+    reloaded = 0;
+    startTime = 0;
+    duration = 0;
+}
+
+ReforgeReloadJob::~ReforgeReloadJob() {}
+
+/*static*/ ReforgeReloadJob* ReforgeReloadJob::instance()
+{
+    static ReforgeReloadJob instance;
+    return &instance;
+}
+
+void ReforgeReloadJob::SetPlayersPerTick(uint32 value)
+{
+    playersPerTick = value > 0 ? value : PLAYERS_PER_TICK_DEFAULT;
+}
+
+void ReforgeReloadJob::Start()
+{
+    // 重载配置可能来自地图线程上的命令, 角色列表在世界线程的 Update 里收集
+    startRequested = true;
+}
+
+void ReforgeReloadJob::Update()
+{
+    if (startRequested.exchange(false))
+    {
+        // 再次切换时重新开始, 已经是最新状态的角色会被跳过
+        players.clear();
+
+        const WorldSessionMgr::SessionMap& sessions = sWorldSessionMgr->GetAllSessions();
+        WorldSessionMgr::SessionMap::const_iterator itr;
+        for (itr = sessions.begin(); itr != sessions.end(); ++itr)
+            if (itr->second && itr->second->GetPlayer())
+                players.push_back(itr->second->GetPlayer()->GetGUID().GetCounter());
+
+        position = 0;
+        total = players.size();
+        reloaded = 0;
+        startTime = getMSTime();
+        duration = 0;
+        state = State::RUNNING;
+    }
+
+    if (state != State::RUNNING)
+        return;
+
+    uint32 count = 0;
+    while (position < players.size() && count < playersPerTick)
+    {
+        Player* player = ObjectAccessor::FindPlayerByLowGUID(players[position++]);
+        ++count;
+
+        if (player && player->IsInWorld() && sItemReforge->ReloadPlayer(player))
+            ++reloaded;
+    }
+
+    duration = GetMSTimeDiffToNow(startTime);
+    if (position < players.size())
+        return;
+
+    state = State::FINISHED;
+    players.clear();
+    players.shrink_to_fit();
+    LOG_INFO("module", "mod_reforging: reforge enable reload finished, {} players checked, {} reloaded in {} ms", total.load(), reloaded.load(), duration.load());
+}
+
+ReforgeReloadJob::State ReforgeReloadJob::GetState() const
+{
+    return state;
+}
+
+uint32 ReforgeReloadJob::GetProcessedCount() const
+{
+    return position;
+}
+
+uint32 ReforgeReloadJob::GetTotalCount() const
+{
+    return total;
+}
+
+uint32 ReforgeReloadJob::GetReloadedCount() const
+{
+    return reloaded;
+}
+
+uint32 ReforgeReloadJob::GetDuration() const
+{
+    return duration;
+}
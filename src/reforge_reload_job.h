@@ -0,0 +1,59 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_RELOAD_JOB_H_
+#define _REFORGE_RELOAD_JOB_H_
+
+#include "Define.h"
+#include <atomic>
+#include <vector>
+
+/*
+ * Reforging.Enable 在重载配置时切换后, 逐个在线角色重新应用装备属性并更新物品查询结果.
+ * 每个世界 tick 只处理有限数量的角色; 角色自己记录属性里是否包含重铸,
+ * 任务进行中登录的角色直接按新开关应用, 下线的角色跳过.
+ */
+class ReforgeReloadJob
+{
+public:
+    enum class State : uint8
+    {
+        IDLE,
+        RUNNING,
+        FINISHED
+    };
+private:
+    static constexpr uint32 PLAYERS_PER_TICK_DEFAULT = 50;
+
+    uint32 playersPerTick;
+    std::atomic<bool> startRequested;
+
+    std::vector<uint32> players;
+    std::atomic<State> state;
+    std::atomic<uint32> position;
+    std::atomic<uint32> total;
+    std::atomic<uint32> reloaded;
+    uint32 startTime;
+    std::atomic<uint32> duration;
+
+    ReforgeReloadJob();
+    ~ReforgeReloadJob();
+public:
+    static ReforgeReloadJob* instance();
+
+    void SetPlayersPerTick(uint32 value);
+
+    void Start();
+    void Update();
+
+    State GetState() const;
+    uint32 GetProcessedCount() const;
+    uint32 GetTotalCount() const;
+    uint32 GetReloadedCount() const;
+    uint32 GetDuration() const;
+};
+
+#define sReforgeReloadJob ReforgeReloadJob::instance()
+
+#endif
@@ -0,0 +1,321 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_snapshot.h"
+#include "Log.h"
+#include "Timer.h"
+#include "reforge_store.h"
+#include "reforge_write_queue.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+ReforgeSnapshot::ReforgeSnapshot()
+{
+    enabled = false;
+    path = "reforge_snapshot.bin";
+    interval = INTERVAL_DEFAULT * IN_MILLISECONDS;
+    timer = interval;
+    writing = false;
+    written = false;
+    writtenGeneration = 0;
+    writes = 0;
+    lastWriteTime = 0;
+    lastLoadTime = 0;
+    loaded = false;
+}
+
+ReforgeSnapshot::~ReforgeSnapshot()
+{
+    JoinWriter();
+}
+
+/*static*/ ReforgeSnapshot* ReforgeSnapshot::instance()
+{
+    static ReforgeSnapshot instance;
+    return &instance;
+}
+
+void ReforgeSnapshot::SetEnabled(bool value)
+{
+    enabled = value;
+}
+
+bool ReforgeSnapshot::GetEnabled() const
+{
+    return enabled;
+}
+
+void ReforgeSnapshot::SetPath(const std::string& value)
+{
+    path = value;
+}
+
+void ReforgeSnapshot::SetInterval(uint32 seconds)
+{
+    interval = (seconds ? seconds : INTERVAL_DEFAULT) * IN_MILLISECONDS;
+    if (timer > interval)
+        timer = interval;
+}
+
+/*static*/ uint64 ReforgeSnapshot::Checksum(const uint8* data, size_t size, uint64 seed)
+{
+    // 按 8 字节处理的 FNV-1a, 数组长度总是 8 的倍数
+    uint64 hash = 0xcbf29ce484222325ULL ^ seed;
+    for (size_t i = 0; i + sizeof(uint64) <= size; i += sizeof(uint64))
+    {
+        uint64 word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash ^= word;
+        hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+}
+
+bool ReforgeSnapshot::Load(uint64 generation, ReforgeFlatMap& reforges)
+{
+    if (!GetEnabled())
+        return false;
+
+    uint32 oldMSTime = getMSTime();
+    const uint8* data = nullptr;
+    size_t size = 0;
+
+#ifndef _WIN32
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG_INFO("server.loading", ">> No reforge snapshot at {}, loading from the database", path);
+        return false;
+    }
+
+    struct stat st;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+        size = size_t(st.st_size);
+        mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if (mapped == MAP_FAILED)
+    {
+        LOG_ERROR("server.loading", ">> Could not map reforge snapshot {}, loading from the database", path);
+        return false;
+    }
+
+    data = static_cast<const uint8*>(mapped);
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file)
+    {
+        LOG_INFO("server.loading", ">> No reforge snapshot at {}, loading from the database", path);
+        return false;
+    }
+
+    std::vector<uint8> buffer;
+    buffer.resize(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+    data = buffer.data();
+    size = buffer.size();
+#endif
+
+    bool valid = false;
+    Header header;
+    if (size >= sizeof(Header))
+    {
+        std::memcpy(&header, data, sizeof(Header));
+        size_t recordBytes = header.capacity * sizeof(ReforgeFlatMap::Record);
+        size_t ownerBytes = header.capacity * sizeof(uint32);
+
+        if (header.magic != MAGIC || header.version != VERSION)
+            LOG_ERROR("server.loading", ">> Reforge snapshot {} has an unknown format, loading from the database", path);
+        else if (header.generation != generation)
+            LOG_INFO("server.loading", ">> Reforge snapshot {} is at generation {}, database is at {}, loading from the database", path, header.generation, generation);
+        else if (header.capacity > size || size != sizeof(Header) + recordBytes + ownerBytes)
+            LOG_ERROR("server.loading", ">> Reforge snapshot {} is truncated, loading from the database", path);
+        else if (Checksum(data + sizeof(Header), recordBytes + ownerBytes, header.generation) != header.checksum)
+            LOG_ERROR("server.loading", ">> Reforge snapshot {} failed its checksum, loading from the database", path);
+        else
+        {
+            std::vector<ReforgeFlatMap::Record> records(header.capacity);
+            std::vector<uint32> owners(header.capacity);
+            std::memcpy(records.data(), data + sizeof(Header), recordBytes);
+            std::memcpy(owners.data(), data + sizeof(Header) + recordBytes, ownerBytes);
+            valid = reforges.Assign(std::move(records), std::move(owners));
+            if (!valid)
+                LOG_ERROR("server.loading", ">> Reforge snapshot {} has an invalid table layout, loading from the database", path);
+        }
+    }
+
+#ifndef _WIN32
+    munmap(const_cast<uint8*>(data), size);
+#endif
+
+    if (!valid)
+        return false;
+
+    loaded = true;
+    written = true;
+    writtenGeneration = generation;
+    lastLoadTime = GetMSTimeDiffToNow(oldMSTime);
+    return true;
+}
+
+/*static*/ bool ReforgeSnapshot::WriteFile(const std::string& path, uint64 generation, const std::vector<ReforgeFlatMap::Record>& records, const std::vector<uint32>& owners)
+{
+    size_t recordBytes = records.size() * sizeof(ReforgeFlatMap::Record);
+    size_t ownerBytes = owners.size() * sizeof(uint32);
+
+    Header header;
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.generation = generation;
+    header.capacity = records.size();
+
+    // 两个数组在文件里是连续的, 校验和也按连续数据计算
+    std::vector<uint8> payload(recordBytes + ownerBytes);
+    std::memcpy(payload.data(), records.data(), recordBytes);
+    std::memcpy(payload.data() + recordBytes, owners.data(), ownerBytes);
+    header.checksum = Checksum(payload.data(), payload.size(), generation);
+
+    // 先写临时文件再改名, 关服中途崩溃也不会留下半个快照
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return false;
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(payload.data()), payload.size());
+        if (!file)
+            return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tmpPath, path, error);
+    return !error;
+}
+
+bool ReforgeSnapshot::Write(bool async)
+{
+    // 只有内存与数据库完全一致时才能写快照
+    if (!sReforgeStore->CanSnapshot())
+        return false;
+
+    uint64 generation = sReforgeWriteQueue->GetGeneration();
+    if (written && generation == writtenGeneration)
+        return false;
+
+    const ReforgeFlatMap& reforges = sReforgeStore->GetResident();
+    std::vector<ReforgeFlatMap::Record> records = reforges.GetRecords();
+    std::vector<uint32> owners = reforges.GetOwners();
+    if (records.empty())
+        return false;
+
+    auto task = [this, generation, records = std::move(records), owners = std::move(owners)]()
+    {
+        uint32 oldMSTime = getMSTime();
+        if (WriteFile(path, generation, records, owners))
+        {
+            writtenGeneration = generation;
+            lastWriteTime = GetMSTimeDiffToNow(oldMSTime);
+            written = true;
+            ++writes;
+        }
+        else
+            LOG_ERROR("module", "mod_reforging: failed to write reforge snapshot {}", path);
+
+        writing = false;
+    };
+
+    writing = true;
+    if (async)
+    {
+        writer = std::thread(std::move(task));
+        return true;
+    }
+
+    task();
+    return written && writtenGeneration == generation;
+}
+
+void ReforgeSnapshot::JoinWriter()
+{
+    if (writer.joinable())
+        writer.join();
+}
+
+void ReforgeSnapshot::Discard()
+{
+    if (path.empty())
+        return;
+
+    std::error_code error;
+    if (std::filesystem::remove(path, error))
+        LOG_INFO("server.loading", ">> Removed reforge snapshot {}, generations are not tracked", path);
+}
+
+void ReforgeSnapshot::Update(uint32 diff)
+{
+    if (!GetEnabled())
+        return;
+
+    if (timer > diff)
+    {
+        timer -= diff;
+        return;
+    }
+
+    timer = interval;
+    if (writing)
+        return;
+
+    JoinWriter();
+    Write(true);
+}
+
+void ReforgeSnapshot::WriteNow()
+{
+    if (!GetEnabled())
+        return;
+
+    JoinWriter();
+    if (Write(false))
+        LOG_INFO("module", "mod_reforging: reforge snapshot at generation {} written to {}", GetWrittenGeneration(), path);
+}
+
+bool ReforgeSnapshot::IsLoaded() const
+{
+    return loaded;
+}
+
+uint64 ReforgeSnapshot::GetWrittenGeneration() const
+{
+    return writtenGeneration;
+}
+
+uint64 ReforgeSnapshot::GetWriteCount() const
+{
+    return writes;
+}
+
+uint32 ReforgeSnapshot::GetLastWriteTime() const
+{
+    return lastWriteTime;
+}
+
+uint32 ReforgeSnapshot::GetLastLoadTime() const
+{
+    return lastLoadTime;
+}
@@ -0,0 +1,80 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_SNAPSHOT_H_
+#define _REFORGE_SNAPSHOT_H_
+
+#include "Define.h"
+#include "reforge_flat_map.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+ * 重铸数据的二进制快照: 文件头之后直接是 ReforgeFlatMap 的槽位数组和拥有者数组.
+ * 启动时用 mmap 映射并校验, 代数与数据库 character_reforging_generation 一致才使用,
+ * 否则回退到数据库载入. 定期写入在后台线程进行, 关服时同步写入一次.
+ */
+class ReforgeSnapshot
+{
+private:
+    static constexpr uint32 MAGIC = 0x53475246; // "FRGS"
+    static constexpr uint32 VERSION = 1;
+    static constexpr uint32 INTERVAL_DEFAULT = 10 * MINUTE;
+
+    struct Header
+    {
+        uint32 magic;
+        uint32 version;
+        uint64 generation;
+        uint64 capacity;
+        uint64 checksum;
+    };
+    static_assert(sizeof(Header) == 32, "ReforgeSnapshot::Header layout changed");
+
+    bool enabled;
+    std::string path;
+    uint32 interval;
+    uint32 timer;
+
+    std::thread writer;
+    std::atomic<bool> writing;
+    std::atomic<bool> written;
+    std::atomic<uint64> writtenGeneration;
+    std::atomic<uint64> writes;
+    std::atomic<uint32> lastWriteTime;
+    std::atomic<uint32> lastLoadTime;
+    bool loaded;
+
+    ReforgeSnapshot();
+    ~ReforgeSnapshot();
+
+    static uint64 Checksum(const uint8* data, size_t size, uint64 seed);
+    static bool WriteFile(const std::string& path, uint64 generation, const std::vector<ReforgeFlatMap::Record>& records, const std::vector<uint32>& owners);
+    bool Write(bool async);
+    void JoinWriter();
+public:
+    static ReforgeSnapshot* instance();
+
+    void SetEnabled(bool value);
+    bool GetEnabled() const;
+    void SetPath(const std::string& value);
+    void SetInterval(uint32 seconds);
+
+    bool Load(uint64 generation, ReforgeFlatMap& reforges);
+    void Discard();
+    void Update(uint32 diff);
+    void WriteNow();
+
+    bool IsLoaded() const;
+    uint64 GetWrittenGeneration() const;
+    uint64 GetWriteCount() const;
+    uint32 GetLastWriteTime() const;
+    uint32 GetLastLoadTime() const;
+};
+
+#define sReforgeSnapshot ReforgeSnapshot::instance()
+
+#endif
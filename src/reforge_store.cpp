@@ -0,0 +1,837 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_store.h"
+#include "Log.h"
+#include "ObjectAccessor.h"
+#include "Player.h"
+#include "StringFormat.h"
+#include "Timer.h"
+#include "reforge_snapshot.h"
+#include "reforge_write_queue.h"
+#include <algorithm>
+
+/*
+ * 重铸存储：数据只保存在 character_reforging, 旧版 item_instance 的 reforge_* 字段
+ * 通过 Reforging.MigrateLegacyColumns 一次性合并进来后删除.
+ * 常驻数据要么启动时全部载入, 要么按角色在登录时异步载入(LazyLoad).
+ * 全部载入时可以用 Reforging.Cache.MaxEntries 限制常驻条数, 超出后按拥有者淘汰离线角色的数据,
+ * 被淘汰的角色再次登录时按 LazyLoad 的方式异步重新载入.
+ */
+
+// 模块发出的同步查询计数, 用于确认装备路径不再阻塞查询数据库
+static std::atomic<uint64> s_SyncQueryCount{ 0 };
+
+template<typename... Args>
+static QueryResult SyncQuery(std::string_view sql, Args&&... args)
+{
+    ++s_SyncQueryCount;
+    return CharacterDatabase.Query(sql, std::forward<Args>(args)...);
+}
+
+ReforgeStore::ReforgeStore()
+{
+    lazyLoad = false;
+    maxEntries = 0;
+    migrateLegacyColumns = false;
+    loadThreads = LOAD_THREADS_DEFAULT;
+    loadStartTime = 0;
+    generationKnown = false;
+    startupSyncQueries = 0;
+    prefetchCheckTimer = PREFETCH_CHECK_INTERVAL_MS;
+    characterLoadsIssued = 0;
+    characterLoadsLate = 0;
+    clockHand = 0;
+    cacheHits = 0;
+    cacheMisses = 0;
+    evictedEntryCount = 0;
+    evictedOwnerCount = 0;
+}
+
+ReforgeStore::~ReforgeStore() {}
+
+/*static*/ ReforgeStore* ReforgeStore::instance()
+{
+    static ReforgeStore instance;
+    return &instance;
+}
+
+void ReforgeStore::SetLazyLoad(bool value)
+{
+    lazyLoad = value;
+}
+
+bool ReforgeStore::GetLazyLoad() const
+{
+    return lazyLoad;
+}
+
+void ReforgeStore::SetMigrateLegacyColumns(bool value)
+{
+    migrateLegacyColumns = value;
+}
+
+void ReforgeStore::SetMaxEntries(uint32 value)
+{
+    bool wasBounded = IsBounded();
+    maxEntries = value;
+
+    // 重载配置后才开启上限, 已常驻的拥有者需要补进轮转
+    if (!wasBounded && IsBounded())
+    {
+        clockRing.clear();
+        clockHand = 0;
+        for (const auto& [guid, owner] : ownerIndex)
+            clockRing.push_back(guid);
+    }
+}
+
+void ReforgeStore::SetLoadThreads(uint32 value)
+{
+    loadThreads = std::clamp<uint32>(value, 1, MAX_LOAD_THREADS);
+}
+
+uint32 ReforgeStore::GetMaxEntries() const
+{
+    return maxEntries;
+}
+
+bool ReforgeStore::IsBounded() const
+{
+    // 按需加载时常驻数据只属于在线角色, 本身就有上限
+    return maxEntries > 0 && !GetLazyLoad();
+}
+
+bool ReforgeStore::HasEvictions()
+{
+    if (IsBounded())
+        return true;
+
+    // 关闭上限后, 之前被淘汰且还没重新载入的角色仍要在登录时重新载入
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    return !evictedOwners.empty();
+}
+
+void ReforgeStore::MigrateLegacyColumns()
+{
+    QueryResult result = SyncQuery("SELECT COUNT(*) FROM information_schema.COLUMNS WHERE TABLE_SCHEMA = DATABASE() AND TABLE_NAME = 'item_instance' "
+        "AND COLUMN_NAME IN ('reforge_decrease', 'reforge_increase', 'reforge_value')");
+    uint64 columns = result ? result->Fetch()[0].Get<uint64>() : 0;
+    if (columns == 0)
+    {
+        LOG_INFO("server.loading", ">> No legacy item_instance reforge columns to migrate");
+        return;
+    }
+
+    if (columns != 3)
+    {
+        LOG_ERROR("server.loading", ">> Table `item_instance` has only {} of the 3 legacy reforge columns, migration skipped", columns);
+        return;
+    }
+
+    uint32 oldMSTime = getMSTime();
+    result = SyncQuery("SELECT COUNT(*) FROM character_reforging");
+    uint64 before = result ? result->Fetch()[0].Get<uint64>() : 0;
+
+    // character_reforging 中已有的记录优先, 旧字段只补充缺失的物品
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    trans->Append("INSERT IGNORE INTO character_reforging (guid, item_guid, stat_decrease, stat_increase, stat_value) "
+        "SELECT owner_guid, guid, reforge_decrease, reforge_increase, reforge_value FROM item_instance WHERE reforge_value <> 0");
+    sReforgeWriteQueue->AppendGenerationBump(trans);
+    if (!ReforgeWriteQueue::CommitAndWait(trans))
+    {
+        LOG_ERROR("server.loading", ">> Failed to copy legacy item_instance reforges into character_reforging, legacy columns kept");
+        return;
+    }
+
+    sReforgeWriteQueue->AdvanceGeneration();
+
+    // 每条旧记录都必须在 character_reforging 里有对应的行, 否则不能删除旧字段
+    QueryResult legacyResult = SyncQuery("SELECT COUNT(*) FROM item_instance WHERE reforge_value <> 0");
+    QueryResult matchedResult = SyncQuery("SELECT COUNT(*) FROM item_instance ii JOIN character_reforging cr ON cr.item_guid = ii.guid WHERE ii.reforge_value <> 0");
+    if (!legacyResult || !matchedResult)
+    {
+        LOG_ERROR("server.loading", ">> Could not verify the legacy item_instance reforge copy, legacy columns kept");
+        return;
+    }
+
+    uint64 legacy = legacyResult->Fetch()[0].Get<uint64>();
+    uint64 matched = matchedResult->Fetch()[0].Get<uint64>();
+    if (matched != legacy)
+    {
+        LOG_ERROR("server.loading", ">> Only {} of {} legacy item_instance reforges are in character_reforging after the copy, legacy columns kept", matched, legacy);
+        return;
+    }
+
+    result = SyncQuery("SELECT COUNT(*) FROM character_reforging");
+    uint64 after = result ? result->Fetch()[0].Get<uint64>() : 0;
+
+    CharacterDatabase.DirectExecute("ALTER TABLE item_instance DROP COLUMN reforge_decrease, DROP COLUMN reforge_increase, DROP COLUMN reforge_value");
+
+    LOG_INFO("server.loading", ">> Migrated {} legacy item_instance reforges into character_reforging and dropped the legacy columns in {} ms",
+        after - before, GetMSTimeDiffToNow(oldMSTime));
+}
+
+void ReforgeStore::LoadGeneration()
+{
+    generationKnown = false;
+    if (sReforgeSnapshot->GetEnabled())
+    {
+        QueryResult result = SyncQuery("SELECT generation FROM character_reforging_generation WHERE id = 0");
+        if (result)
+        {
+            generationKnown = true;
+            sReforgeWriteQueue->SetGeneration(result->Fetch()[0].Get<uint64>());
+        }
+        else
+            LOG_ERROR("sql.sql", "Table `character_reforging_generation` is missing or empty, reforge snapshots are disabled");
+    }
+
+    // 不跟踪代数时的修改不会让旧快照过期, 旧快照必须删除
+    sReforgeWriteQueue->SetGenerationTracking(generationKnown);
+    if (!generationKnown)
+        sReforgeSnapshot->Discard();
+}
+
+void ReforgeStore::RebuildOwnerIndex()
+{
+    ownerIndex.clear();
+    clockRing.clear();
+    clockHand = 0;
+    reforges.ForEach([this](const ReforgeFlatMap::Record& record, uint32 owner)
+    {
+        std::pair<OwnerIndexContainer::iterator, bool> entry = ownerIndex.try_emplace(owner, OwnerEntry{ {}, false });
+        entry.first->second.items.push_back(record.item_guid);
+        if (entry.second && IsBounded())
+            clockRing.push_back(owner);
+    });
+}
+
+void ReforgeStore::StartLoading()
+{
+    reforges.Clear();
+    ownerIndex.clear();
+    clockRing.clear();
+    clockHand = 0;
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        evictedOwners.clear();
+    }
+
+    LoadGeneration();
+
+    if (migrateLegacyColumns)
+        MigrateLegacyColumns();
+
+    loadStartTime = getMSTime();
+
+    if (GetLazyLoad())
+    {
+        startupSyncQueries = GetSyncQueryCount();
+        LOG_INFO("server.loading", ">> Item reforges are loaded per character on login");
+        LOG_INFO("server.loading", " ");
+        return;
+    }
+
+    if (generationKnown && sReforgeSnapshot->Load(sReforgeWriteQueue->GetGeneration(), reforges))
+    {
+        RebuildOwnerIndex();
+        startupSyncQueries = GetSyncQueryCount();
+        LOG_INFO("server.loading", ">> Loaded {} item reforges ({} KB) from snapshot at generation {} in {} ms", reforges.Size(), GetMemoryUsage() / 1024,
+            sReforgeWriteQueue->GetGeneration(), GetMSTimeDiffToNow(loadStartTime));
+        LOG_INFO("server.loading", " ");
+        return;
+    }
+
+    QueryResult result = SyncQuery("SELECT COUNT(*), MIN(item_guid), MAX(item_guid) FROM character_reforging");
+    uint64 rows = result ? result->Fetch()[0].Get<uint64>() : 0;
+    if (rows == 0)
+    {
+        startupSyncQueries = GetSyncQueryCount();
+        LOG_INFO("server.loading", ">> Loaded 0 item reforges.");
+        LOG_INFO("server.loading", " ");
+        return;
+    }
+
+    uint32 first = result->Fetch()[1].Get<uint32>();
+    uint32 last = result->Fetch()[2].Get<uint32>();
+
+    // 行数太少时分区没有意义
+    uint32 partitions = rows < MIN_ROWS_PER_PARTITION ? 1 : uint32(std::min<uint64>(loadThreads, rows / MIN_ROWS_PER_PARTITION));
+    partitions = std::max<uint32>(1, std::min<uint32>(partitions, last - first + 1));
+    uint32 span = (last - first) / partitions + 1;
+
+    reforges.Reserve(rows);
+    loadPartitions.resize(partitions);
+    for (uint32 i = 0; i < partitions; ++i)
+    {
+        LoadPartition& partition = loadPartitions[i];
+        partition.first = first + i * span;
+        partition.last = i + 1 == partitions ? last : partition.first + span - 1;
+        partition.rows.clear();
+    }
+
+    // 每个分区一个线程, 各自取一个数据库连接查询并解码, 与世界初始化的其他载入并行
+    for (LoadPartition& partition : loadPartitions)
+        loadWorkers.emplace_back([&partition]()
+        {
+            uint32 oldMSTime = getMSTime();
+            QueryResult result = SyncQuery("SELECT guid, item_guid, stat_decrease, stat_increase, stat_value FROM character_reforging "
+                "WHERE item_guid BETWEEN {} AND {}", partition.first, partition.last);
+            if (result)
+            {
+                partition.rows.reserve(result->GetRowCount());
+                do
+                {
+                    Field* fields = result->Fetch();
+
+                    ItemReforge::ReforgingData reforgingData;
+                    reforgingData.guid = fields[0].Get<uint32>();
+                    reforgingData.item_guid = fields[1].Get<uint32>();
+                    reforgingData.stat_decrease = fields[2].Get<uint32>();
+                    reforgingData.stat_increase = fields[3].Get<uint32>();
+                    reforgingData.stat_value = fields[4].Get<uint32>();
+                    partition.rows.push_back(reforgingData);
+                } while (result->NextRow());
+            }
+
+            partition.loadTime = GetMSTimeDiffToNow(oldMSTime);
+        });
+
+    LOG_INFO("server.loading", ">> Loading {} item reforges in {} partitions in the background", rows, partitions);
+}
+
+void ReforgeStore::FinishLoading()
+{
+    if (loadWorkers.empty())
+        return;
+
+    uint32 waitStartTime = getMSTime();
+    for (std::thread& worker : loadWorkers)
+        worker.join();
+    loadWorkers.clear();
+
+    uint32 waitTime = GetMSTimeDiffToNow(waitStartTime);
+    uint32 slowestPartition = 0;
+    for (LoadPartition& partition : loadPartitions)
+    {
+        slowestPartition = std::max(slowestPartition, partition.loadTime);
+        for (const ItemReforge::ReforgingData& reforgingData : partition.rows)
+            if (!AddResident(reforgingData))
+                LOG_ERROR("sql.sql", "Table `character_reforging` has out of range reforge (decrease {}, increase {}, value {}) for item_guid {}, skipped.",
+                    reforgingData.stat_decrease, reforgingData.stat_increase, reforgingData.stat_value, reforgingData.item_guid);
+    }
+
+    uint32 partitions = loadPartitions.size();
+    std::vector<LoadPartition>().swap(loadPartitions);
+    startupSyncQueries = GetSyncQueryCount();
+
+    uint32 totalTime = GetMSTimeDiffToNow(loadStartTime);
+    uint64 rowsPerSecond = uint64(reforges.Size()) * IN_MILLISECONDS / std::max<uint32>(totalTime, 1);
+    LOG_INFO("server.loading", ">> Loaded {} item reforges ({} KB) in {} ms using {} partitions ({} rows/s, slowest partition {} ms, world init waited {} ms)",
+        reforges.Size(), GetMemoryUsage() / 1024, totalTime, partitions, rowsPerSecond, slowestPartition, waitTime);
+    if (IsBounded() && reforges.Size() > maxEntries)
+        LOG_INFO("server.loading", ">> Item reforges exceed Reforging.Cache.MaxEntries ({}), offline characters will be evicted after startup", maxEntries);
+    LOG_INFO("server.loading", " ");
+}
+
+bool ReforgeStore::AddResident(const ItemReforge::ReforgingData& reforgingData)
+{
+    if (reforgingData.stat_decrease > ReforgeFlatMap::MAX_STAT_TYPE || reforgingData.stat_increase > ReforgeFlatMap::MAX_STAT_TYPE
+        || reforgingData.stat_value > ReforgeFlatMap::MAX_STAT_VALUE)
+        return false;
+
+    uint32 owner = 0;
+    bool indexed = reforges.Find(reforgingData.item_guid, &owner) != nullptr;
+    if (indexed && owner != reforgingData.guid)
+    {
+        RemoveResident(reforgingData.item_guid);
+        indexed = false;
+    }
+
+    reforges.Insert(reforgingData.item_guid, reforgingData.guid, uint8(reforgingData.stat_decrease), uint8(reforgingData.stat_increase), uint16(reforgingData.stat_value));
+    if (!indexed)
+    {
+        std::pair<OwnerIndexContainer::iterator, bool> owner = ownerIndex.try_emplace(reforgingData.guid, OwnerEntry{ {}, false });
+        owner.first->second.items.push_back(reforgingData.item_guid);
+        if (owner.second && IsBounded())
+            clockRing.push_back(reforgingData.guid);
+    }
+
+    return true;
+}
+
+void ReforgeStore::RemoveResident(uint32 itemGuid)
+{
+    uint32 owner = 0;
+    if (!reforges.Find(itemGuid, &owner))
+        return;
+
+    reforges.Erase(itemGuid);
+
+    OwnerIndexContainer::iterator itr = ownerIndex.find(owner);
+    if (itr == ownerIndex.end())
+        return;
+
+    std::vector<uint32>& items = itr->second.items;
+    std::vector<uint32>::iterator item = std::find(items.begin(), items.end(), itemGuid);
+    if (item != items.end())
+    {
+        *item = items.back();
+        items.pop_back();
+    }
+
+    if (items.empty())
+        ownerIndex.erase(itr);
+}
+
+void ReforgeStore::RemoveCharacterResident(uint32 guid)
+{
+    OwnerIndexContainer::iterator itr = ownerIndex.find(guid);
+    if (itr == ownerIndex.end())
+        return;
+
+    for (uint32 itemGuid : itr->second.items)
+        reforges.Erase(itemGuid);
+
+    ownerIndex.erase(itr);
+}
+
+void ReforgeStore::EvictColdOwners()
+{
+    if (!IsBounded() || reforges.Size() <= maxEntries)
+        return;
+
+    // 淘汰到上限的 90%, 避免每个 tick 都在边界上来回淘汰; 每个 tick 最多转一圈
+    size_t target = maxEntries - maxEntries / 10;
+    size_t steps = clockRing.size();
+    uint32 evicted = 0;
+
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    while (reforges.Size() > target && steps > 0 && evicted < MAX_OWNER_EVICTIONS_PER_TICK && !clockRing.empty())
+    {
+        --steps;
+        if (clockHand >= clockRing.size())
+            clockHand = 0;
+
+        uint32 guid = clockRing[clockHand];
+        OwnerIndexContainer::iterator itr = ownerIndex.find(guid);
+        if (itr == ownerIndex.end())
+        {
+            // 拥有者已经没有常驻数据, 顺便清掉这个位置
+            clockRing[clockHand] = clockRing.back();
+            clockRing.pop_back();
+            continue;
+        }
+
+        if (itr->second.referenced)
+        {
+            itr->second.referenced = false;
+            ++clockHand;
+            continue;
+        }
+
+        // 还有未写入数据库的修改时不淘汰, 否则重新载入会读到旧数据
+        if (characterLoads.find(guid) != characterLoads.end() || ObjectAccessor::FindPlayerByLowGUID(guid)
+            || sReforgeWriteQueue->HasPendingOwner(guid))
+        {
+            ++clockHand;
+            continue;
+        }
+
+        evictedEntryCount += itr->second.items.size();
+        ++evictedOwnerCount;
+        ++evicted;
+        for (uint32 itemGuid : itr->second.items)
+            reforges.Erase(itemGuid);
+
+        ownerIndex.erase(itr);
+        evictedOwners.insert(guid);
+        clockRing[clockHand] = clockRing.back();
+        clockRing.pop_back();
+    }
+
+    if (evicted > 0 && reforges.Size() <= target)
+        reforges.Shrink();
+}
+
+/*static*/ ItemReforge::ReforgingData ReforgeStore::ToReforgingData(const ReforgeFlatMap::Record& record, uint32 owner)
+{
+    ItemReforge::ReforgingData reforgingData;
+    reforgingData.guid = owner;
+    reforgingData.item_guid = record.item_guid;
+    reforgingData.stat_decrease = record.stat_decrease;
+    reforgingData.stat_increase = record.stat_increase;
+    reforgingData.stat_value = record.stat_value;
+    return reforgingData;
+}
+
+std::optional<ItemReforge::ReforgingData> ReforgeStore::Get(uint32 itemGuid) const
+{
+    uint32 owner = 0;
+    if (const ReforgeFlatMap::Record* record = reforges.Find(itemGuid, &owner))
+        return ToReforgingData(*record, owner);
+
+    return std::nullopt;
+}
+
+bool ReforgeStore::Contains(uint32 itemGuid) const
+{
+    return reforges.Contains(itemGuid);
+}
+
+std::vector<ItemReforge::ReforgingData> ReforgeStore::GetCharacterReforges(uint32 guid) const
+{
+    std::vector<ItemReforge::ReforgingData> result;
+    OwnerIndexContainer::const_iterator itr = ownerIndex.find(guid);
+    if (itr == ownerIndex.end())
+        return result;
+
+    result.reserve(itr->second.items.size());
+    for (uint32 itemGuid : itr->second.items)
+        if (const ReforgeFlatMap::Record* record = reforges.Find(itemGuid))
+            result.push_back(ToReforgingData(*record, guid));
+
+    return result;
+}
+
+uint32 ReforgeStore::GetCharacterReforgeCount(uint32 guid) const
+{
+    OwnerIndexContainer::const_iterator itr = ownerIndex.find(guid);
+    return itr != ownerIndex.end() ? itr->second.items.size() : 0;
+}
+
+bool ReforgeStore::Set(const ItemReforge::ReforgingData& reforgingData)
+{
+    if (!AddResident(reforgingData))
+        return false;
+
+    OwnerIndexContainer::iterator itr = ownerIndex.find(reforgingData.guid);
+    if (itr != ownerIndex.end())
+        itr->second.referenced = true;
+
+    sReforgeWriteQueue->QueueReforge(reforgingData);
+    return true;
+}
+
+void ReforgeStore::Remove(uint32 itemGuid, uint32 guid)
+{
+    // 按需加载时记录可能不在内存里, 数据库删除仍然要提交
+    RemoveResident(itemGuid);
+    sReforgeWriteQueue->QueueRemove(itemGuid, guid);
+}
+
+void ReforgeStore::RemoveCharacter(CharacterDatabaseTransaction trans, uint32 guid)
+{
+    // 数据库记录随角色删除事务一起删除, 代数在这里先递增, 事务失败时快照只会被判定为过期
+    trans->Append("DELETE FROM character_reforging WHERE guid = {}", guid);
+    sReforgeWriteQueue->AppendGenerationBump(trans);
+    sReforgeWriteQueue->AdvanceGeneration();
+
+    sReforgeWriteQueue->DiscardOwner(guid);
+
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        characterLoads.erase(guid);
+        evictedOwners.erase(guid);
+    }
+
+    RemoveCharacterResident(guid);
+}
+
+const ReforgeFlatMap& ReforgeStore::GetResident() const
+{
+    return reforges;
+}
+
+bool ReforgeStore::CanSnapshot()
+{
+    // 快照必须是完整的表: 按需加载或有角色被淘汰时内存里只有一部分数据
+    if (GetLazyLoad() || !generationKnown || HasEvictions())
+        return false;
+
+    return sReforgeWriteQueue->GetQueueDepth() == 0 && !sReforgeWriteQueue->IsFlushInFlight();
+}
+
+void ReforgeStore::RequestCharacterLoad(uint32 guid, bool loggedIn)
+{
+    // 调用方需持有 characterLoadLock
+    CharacterLoad& load = characterLoads[guid];
+    load.state = CharacterLoadState::LOADING;
+    load.loggedIn = loggedIn;
+    load.requestTime = getMSTime();
+    ++characterLoadsIssued;
+
+    pendingCharacterLoads.push_back(CharacterDatabase.AsyncQuery(Acore::StringFormat(
+        "SELECT item_guid, stat_decrease, stat_increase, stat_value FROM character_reforging WHERE guid = {}", guid))
+        .WithCallback([this, guid](QueryResult result) { HandleCharacterLoaded(guid, result); }));
+}
+
+void ReforgeStore::PrefetchCharacter(uint32 guid)
+{
+    if (!GetLazyLoad() && !HasEvictions())
+        return;
+
+    // 在网络线程收到登录请求时就发起查询, 通常能赶在角色装备属性计算之前返回
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    if (characterLoads.find(guid) != characterLoads.end())
+        return;
+
+    if (!GetLazyLoad())
+    {
+        // 数据仍然常驻, 不需要查询
+        if (evictedOwners.erase(guid) == 0)
+            return;
+
+        ++cacheMisses;
+    }
+
+    RequestCharacterLoad(guid, false);
+}
+
+void ReforgeStore::HandleLogin(uint32 guid)
+{
+    if (!GetLazyLoad() && !HasEvictions())
+        return;
+
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    CharacterLoadContainer::iterator itr = characterLoads.find(guid);
+    if (itr != characterLoads.end())
+    {
+        itr->second.loggedIn = true;
+        return;
+    }
+
+    if (!GetLazyLoad())
+    {
+        if (evictedOwners.erase(guid) == 0)
+        {
+            ++cacheHits;
+            return;
+        }
+
+        ++cacheMisses;
+    }
+
+    RequestCharacterLoad(guid, true);
+}
+
+void ReforgeStore::HandleLogout(uint32 guid)
+{
+    if (!GetLazyLoad())
+    {
+        // 刚下线的角色在下一轮淘汰中有第二次机会
+        OwnerIndexContainer::iterator itr = ownerIndex.find(guid);
+        if (itr != ownerIndex.end())
+            itr->second.referenced = true;
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        CharacterLoadContainer::iterator itr = characterLoads.find(guid);
+        // 还有未写入数据库的修改: 保留在内存中, 否则马上重新登录会从数据库读到旧数据
+        // 写入完成后由 ExpirePrefetches 清除
+        if (itr != characterLoads.end() && sReforgeWriteQueue->HasPendingOwner(guid))
+        {
+            itr->second.loggedIn = false;
+            itr->second.requestTime = getMSTime();
+            return;
+        }
+
+        characterLoads.erase(guid);
+    }
+
+    RemoveCharacterResident(guid);
+}
+
+void ReforgeStore::HandleCharacterLoaded(uint32 guid, QueryResult result)
+{
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        CharacterLoadContainer::iterator itr = characterLoads.find(guid);
+        // 结果返回前角色已经下线或预取已过期
+        if (itr == characterLoads.end())
+            return;
+
+        // 全部载入模式下只是补回被淘汰的数据, 载入完成后不再需要跟踪
+        if (GetLazyLoad())
+            itr->second.state = CharacterLoadState::LOADED;
+        else
+            characterLoads.erase(itr);
+    }
+
+    if (!result)
+        return;
+
+    Player* player = ObjectAccessor::FindPlayerByLowGUID(guid);
+    if (player && !player->IsInWorld())
+        player = nullptr;
+
+    if (player)
+        ++characterLoadsLate;
+
+    do
+    {
+        Field* fields = result->Fetch();
+
+        ItemReforge::ReforgingData reforgingData;
+        reforgingData.guid = guid;
+        reforgingData.item_guid = fields[0].Get<uint32>();
+        reforgingData.stat_decrease = fields[1].Get<uint32>();
+        reforgingData.stat_increase = fields[2].Get<uint32>();
+        reforgingData.stat_value = fields[3].Get<uint32>();
+
+        // 数据晚于登录到达: 已装备的物品按无重铸的属性计算过, 需要重新应用
+        Item* item = player ? player->GetItemByGuid(ObjectGuid::Create<HighGuid::Item>(reforgingData.item_guid)) : nullptr;
+        bool reapply = item && item->IsEquipped();
+        if (reapply)
+            player->_ApplyItemMods(item, item->GetSlot(), false);
+
+        if (!AddResident(reforgingData))
+            LOG_ERROR("sql.sql", "Table `character_reforging` has out of range reforge for item_guid {}, skipped.", reforgingData.item_guid);
+
+        if (reapply)
+            sItemReforge->InvalidateEquippedReforge(player, item);
+
+        if (reapply)
+            player->_ApplyItemMods(item, item->GetSlot(), true);
+
+        if (item)
+            sItemReforge->SendItemPacket(player, item);
+    } while (result->NextRow());
+}
+
+void ReforgeStore::ExpirePrefetches()
+{
+    std::vector<uint32> expired;
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        for (CharacterLoadContainer::iterator itr = characterLoads.begin(); itr != characterLoads.end(); )
+        {
+            // 预取后一直没有真正登录(登录失败), 或下线时保留的数据已经写入数据库
+            if (!itr->second.loggedIn && GetMSTimeDiffToNow(itr->second.requestTime) > PREFETCH_EXPIRE_MS
+                && !ObjectAccessor::FindPlayerByLowGUID(itr->first) && !sReforgeWriteQueue->HasPendingOwner(itr->first))
+            {
+                expired.push_back(itr->first);
+                itr = characterLoads.erase(itr);
+            }
+            else
+                ++itr;
+        }
+    }
+
+    for (uint32 guid : expired)
+        RemoveCharacterResident(guid);
+}
+
+bool ReforgeStore::IsCharacterLoaded(uint32 guid)
+{
+    if (!GetLazyLoad() && !HasEvictions())
+        return true;
+
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    CharacterLoadContainer::const_iterator itr = characterLoads.find(guid);
+    if (!GetLazyLoad())
+        return itr == characterLoads.end() && evictedOwners.find(guid) == evictedOwners.end();
+
+    return itr != characterLoads.end() && itr->second.state == CharacterLoadState::LOADED;
+}
+
+void ReforgeStore::Update(uint32 diff)
+{
+    {
+        std::lock_guard<std::mutex> guard(characterLoadLock);
+        for (QueryCallback& callback : pendingCharacterLoads)
+            characterLoadCallbacks.AddCallback(std::move(callback));
+        pendingCharacterLoads.clear();
+    }
+
+    characterLoadCallbacks.ProcessReadyCallbacks();
+
+    if (!GetLazyLoad())
+    {
+        EvictColdOwners();
+        return;
+    }
+
+    if (prefetchCheckTimer <= diff)
+    {
+        prefetchCheckTimer = PREFETCH_CHECK_INTERVAL_MS;
+        ExpirePrefetches();
+    }
+    else
+        prefetchCheckTimer -= diff;
+}
+
+/*static*/ uint64 ReforgeStore::GetSyncQueryCount()
+{
+    return s_SyncQueryCount;
+}
+
+uint64 ReforgeStore::GetStartupSyncQueryCount() const
+{
+    return startupSyncQueries;
+}
+
+uint32 ReforgeStore::GetReforgeCount() const
+{
+    return reforges.Size();
+}
+
+uint32 ReforgeStore::GetReforgeOwnerCount() const
+{
+    return ownerIndex.size();
+}
+
+size_t ReforgeStore::GetMemoryUsage() const
+{
+    size_t bytes = reforges.MemoryUsage() + clockRing.capacity() * sizeof(uint32);
+    for (const auto& [guid, owner] : ownerIndex)
+        bytes += sizeof(guid) + sizeof(owner) + owner.items.capacity() * sizeof(uint32);
+
+    return bytes;
+}
+
+uint32 ReforgeStore::GetLoadedCharacterCount()
+{
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    return characterLoads.size();
+}
+
+uint64 ReforgeStore::GetCharacterLoadsIssued() const
+{
+    return characterLoadsIssued;
+}
+
+uint64 ReforgeStore::GetCharacterLoadsLate() const
+{
+    return characterLoadsLate;
+}
+
+uint64 ReforgeStore::GetCacheHits() const
+{
+    return cacheHits;
+}
+
+uint64 ReforgeStore::GetCacheMisses() const
+{
+    return cacheMisses;
+}
+
+uint64 ReforgeStore::GetEvictedEntryCount() const
+{
+    return evictedEntryCount;
+}
+
+uint64 ReforgeStore::GetEvictedOwnerCount() const
+{
+    return evictedOwnerCount;
+}
+
+uint32 ReforgeStore::GetColdOwnerCount()
+{
+    std::lock_guard<std::mutex> guard(characterLoadLock);
+    return evictedOwners.size();
+}
@@ -0,0 +1,157 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_STORE_H_
+#define _REFORGE_STORE_H_
+
+#include "Define.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include "item_reforge.h"
+#include "reforge_flat_map.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/*
+ * 重铸数据的唯一存储: character_reforging 是唯一的表结构, 内存里只有一份常驻数据,
+ * 所有读取都由这里应答, 所有修改都经这里写入内存并进入写入队列.
+ */
+class ReforgeStore
+{
+private:
+    static constexpr uint32 PREFETCH_EXPIRE_MS = 5 * MINUTE * IN_MILLISECONDS;
+    static constexpr uint32 PREFETCH_CHECK_INTERVAL_MS = 30 * IN_MILLISECONDS;
+    static constexpr uint32 MAX_OWNER_EVICTIONS_PER_TICK = 1000;
+    static constexpr uint32 LOAD_THREADS_DEFAULT = 4;
+    static constexpr uint32 MAX_LOAD_THREADS = 16;
+    static constexpr uint64 MIN_ROWS_PER_PARTITION = 50000;
+
+    enum class CharacterLoadState : uint8
+    {
+        LOADING,
+        LOADED
+    };
+
+    struct CharacterLoad
+    {
+        CharacterLoadState state;
+        bool loggedIn;
+        uint32 requestTime;
+    };
+
+    struct OwnerEntry
+    {
+        std::vector<uint32> items;
+        bool referenced;
+    };
+
+    struct LoadPartition
+    {
+        uint32 first;
+        uint32 last;
+        uint32 loadTime;
+        std::vector<ItemReforge::ReforgingData> rows;
+    };
+
+    typedef std::unordered_map<uint32, CharacterLoad> CharacterLoadContainer;
+    typedef std::unordered_map<uint32, OwnerEntry> OwnerIndexContainer;
+
+    bool lazyLoad;
+    uint32 maxEntries;
+    bool migrateLegacyColumns;
+    uint32 loadThreads;
+    bool generationKnown;
+    uint64 startupSyncQueries;
+
+    ReforgeFlatMap reforges;
+    OwnerIndexContainer ownerIndex;
+
+    std::vector<LoadPartition> loadPartitions;
+    std::vector<std::thread> loadWorkers;
+    uint32 loadStartTime;
+
+    // CLOCK 淘汰: 按拥有者轮转, 最近活动过的拥有者有第二次机会, 在线拥有者不淘汰
+    std::vector<uint32> clockRing;
+    size_t clockHand;
+    std::unordered_set<uint32> evictedOwners;
+    std::atomic<uint64> cacheHits;
+    std::atomic<uint64> cacheMisses;
+    std::atomic<uint64> evictedEntryCount;
+    std::atomic<uint64> evictedOwnerCount;
+
+    std::mutex characterLoadLock;
+    CharacterLoadContainer characterLoads;
+    std::vector<QueryCallback> pendingCharacterLoads;
+    AsyncCallbackProcessor<QueryCallback> characterLoadCallbacks;
+    uint32 prefetchCheckTimer;
+    std::atomic<uint64> characterLoadsIssued;
+    std::atomic<uint64> characterLoadsLate;
+
+    ReforgeStore();
+    ~ReforgeStore();
+
+    void MigrateLegacyColumns();
+    void LoadGeneration();
+    void RebuildOwnerIndex();
+    void RequestCharacterLoad(uint32 guid, bool loggedIn);
+    void HandleCharacterLoaded(uint32 guid, QueryResult result);
+    void ExpirePrefetches();
+    bool IsBounded() const;
+    bool HasEvictions();
+    void EvictColdOwners();
+    bool AddResident(const ItemReforge::ReforgingData& reforgingData);
+    void RemoveResident(uint32 itemGuid);
+    void RemoveCharacterResident(uint32 guid);
+    static ItemReforge::ReforgingData ToReforgingData(const ReforgeFlatMap::Record& record, uint32 owner);
+public:
+    static ReforgeStore* instance();
+
+    void SetLazyLoad(bool value);
+    bool GetLazyLoad() const;
+    void SetMigrateLegacyColumns(bool value);
+    void SetMaxEntries(uint32 value);
+    void SetLoadThreads(uint32 value);
+    uint32 GetMaxEntries() const;
+    void StartLoading();
+    void FinishLoading();
+
+    std::optional<ItemReforge::ReforgingData> Get(uint32 itemGuid) const;
+    bool Contains(uint32 itemGuid) const;
+    std::vector<ItemReforge::ReforgingData> GetCharacterReforges(uint32 guid) const;
+    uint32 GetCharacterReforgeCount(uint32 guid) const;
+    bool Set(const ItemReforge::ReforgingData& reforgingData);
+    void Remove(uint32 itemGuid, uint32 guid);
+    void RemoveCharacter(CharacterDatabaseTransaction trans, uint32 guid);
+    const ReforgeFlatMap& GetResident() const;
+    bool CanSnapshot();
+
+    void PrefetchCharacter(uint32 guid);
+    void HandleLogin(uint32 guid);
+    void HandleLogout(uint32 guid);
+    bool IsCharacterLoaded(uint32 guid);
+    void Update(uint32 diff);
+
+    static uint64 GetSyncQueryCount();
+    uint64 GetStartupSyncQueryCount() const;
+    uint32 GetReforgeCount() const;
+    uint32 GetReforgeOwnerCount() const;
+    size_t GetMemoryUsage() const;
+    uint32 GetLoadedCharacterCount();
+    uint64 GetCharacterLoadsIssued() const;
+    uint64 GetCharacterLoadsLate() const;
+    uint64 GetCacheHits() const;
+    uint64 GetCacheMisses() const;
+    uint64 GetEvictedEntryCount() const;
+    uint64 GetEvictedOwnerCount() const;
+    uint32 GetColdOwnerCount();
+};
+
+#define sReforgeStore ReforgeStore::instance()
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_text.h"
+#include <charconv>
+#include <cstring>
+
+ReforgeTextWriter::ReforgeTextWriter(char* buffer, size_t size)
+{
+    data = buffer;
+    capacity = size;
+    length = 0;
+    truncated = false;
+}
+
+ReforgeTextWriter& ReforgeTextWriter::Append(std::string_view text)
+{
+    size_t count = text.size();
+    if (count > capacity - length)
+    {
+        count = capacity - length;
+        truncated = true;
+    }
+
+    std::memcpy(data + length, text.data(), count);
+    length += count;
+    return *this;
+}
+
+ReforgeTextWriter& ReforgeTextWriter::Append(char c)
+{
+    if (length < capacity)
+        data[length++] = c;
+    else
+        truncated = true;
+
+    return *this;
+}
+
+ReforgeTextWriter& ReforgeTextWriter::AppendNumber(int64 value)
+{
+    char digits[24];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value);
+    return Append(std::string_view(digits, result.ptr - digits));
+}
+
+ReforgeTextWriter& ReforgeTextWriter::AppendHex(uint32 value)
+{
+    char digits[8];
+    std::to_chars_result result = std::to_chars(digits, digits + sizeof(digits), value, 16);
+    return Append(std::string_view(digits, result.ptr - digits));
+}
+
+ReforgeTextWriter& ReforgeTextWriter::AppendColored(std::string_view text, std::string_view color)
+{
+    return Append("|cff").Append(color).Append(text).Append("|r");
+}
+
+void ReforgeTextWriter::Clear()
+{
+    length = 0;
+    truncated = false;
+}
+
+std::string_view ReforgeTextWriter::View() const
+{
+    return std::string_view(data, length);
+}
+
+size_t ReforgeTextWriter::GetLength() const
+{
+    return length;
+}
+
+bool ReforgeTextWriter::IsTruncated() const
+{
+    return truncated;
+}
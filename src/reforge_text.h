@@ -0,0 +1,55 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_TEXT_H_
+#define _REFORGE_TEXT_H_
+
+#include "Define.h"
+#include <array>
+#include <string_view>
+
+/*
+ * 把菜单和消息文本写进调用方提供的定长缓冲区, 不做任何堆分配.
+ * 写满后多余的内容被丢弃并记下截断, View() 始终是已写入的完整前缀.
+ */
+class ReforgeTextWriter
+{
+private:
+    char* data;
+    size_t capacity;
+    size_t length;
+    bool truncated;
+public:
+    ReforgeTextWriter(char* buffer, size_t size);
+    ReforgeTextWriter(const ReforgeTextWriter&) = delete;
+    ReforgeTextWriter& operator=(const ReforgeTextWriter&) = delete;
+
+    ReforgeTextWriter& Append(std::string_view text);
+    ReforgeTextWriter& Append(char c);
+    ReforgeTextWriter& AppendNumber(int64 value);
+    ReforgeTextWriter& AppendHex(uint32 value);
+    // |cff<color>text|r
+    ReforgeTextWriter& AppendColored(std::string_view text, std::string_view color);
+
+    void Clear();
+    std::string_view View() const;
+    size_t GetLength() const;
+    bool IsTruncated() const;
+};
+
+template<size_t N>
+struct ReforgeTextStorage
+{
+    std::array<char, N> storage;
+};
+
+// 自带存储的写入器, 放在栈上使用; 存储基类先于写入器构造
+template<size_t N>
+class ReforgeTextBuffer : private ReforgeTextStorage<N>, public ReforgeTextWriter
+{
+public:
+    ReforgeTextBuffer() : ReforgeTextWriter(ReforgeTextStorage<N>::storage.data(), N) {}
+};
+
+#endif
@@ -0,0 +1,399 @@
+/*
+ * Credits: silviu20092
+ */
+
+#include "reforge_write_queue.h"
+#include "Log.h"
+#include "StringConvert.h"
+#include "StringFormat.h"
+#include "Timer.h"
+#include <chrono>
+#include <thread>
+
+/*
+ * 重铸写入队列：同一个世界 tick 内的所有修改合并为一个异步事务提交.
+ * 同一 item_guid 的多次修改只保留最后结果, 本 tick 新插入又被删除的记录直接抵消.
+ * 任意时刻最多只有一个事务在途, 保证提交顺序与修改顺序一致.
+ * 启用快照时每个事务同时递增 character_reforging_generation, 快照据此判断是否与数据库一致.
+ */
+
+ReforgeWriteQueue::ReforgeWriteQueue()
+{
+    inFlight = false;
+    generation = 0;
+    generationTracking = false;
+    flushes = 0;
+    failedFlushes = 0;
+    flushedMutations = 0;
+    flushedStatements = 0;
+    coalescedMutations = 0;
+    lastFlushLatency = 0;
+    maxFlushLatency = 0;
+    totalFlushLatency = 0;
+}
+
+ReforgeWriteQueue::~ReforgeWriteQueue() {}
+
+/*static*/ ReforgeWriteQueue* ReforgeWriteQueue::instance()
+{
+    static ReforgeWriteQueue instance;
+    return &instance;
+}
+
+/*static*/ const char* ReforgeWriteQueue::GetStatement(ReforgeStatements index)
+{
+    static constexpr const char* statements[MAX_REFORGE_STATEMENTS] =
+    {
+        "REPLACE INTO character_reforging (guid, item_guid, stat_decrease, stat_increase, stat_value) VALUES ",
+        "DELETE FROM character_reforging WHERE item_guid IN (",
+        "UPDATE character_reforging_generation SET generation = generation + 1 WHERE id = 0"
+    };
+
+    return statements[index];
+}
+
+void ReforgeWriteQueue::QueueReforge(const ItemReforge::ReforgingData& data)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    ReforgeOpContainer::iterator itr = reforgeOps.find(data.item_guid);
+    if (itr == reforgeOps.end())
+    {
+        reforgeOps[data.item_guid] = { OpType::INSERT, data, false };
+        return;
+    }
+
+    // 本 tick 已有删除, 数据库里可能还留着旧记录, 只能覆盖写入
+    if (itr->second.type == OpType::REMOVE)
+        itr->second.type = OpType::UPSERT;
+    itr->second.data = data;
+    ++coalescedMutations;
+}
+
+void ReforgeWriteQueue::QueueRemove(uint32 itemGuid, uint32 guid)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    ReforgeOpContainer::iterator itr = reforgeOps.find(itemGuid);
+    if (itr == reforgeOps.end())
+    {
+        ReforgeOp op;
+        op.type = OpType::REMOVE;
+        op.data = { guid, itemGuid, 0, 0, 0 };
+        op.rowMayExist = true;
+        reforgeOps[itemGuid] = op;
+        return;
+    }
+
+    if (itr->second.type == OpType::INSERT && !itr->second.rowMayExist)
+    {
+        // 插入还没写入数据库, 插入与删除一起抵消
+        reforgeOps.erase(itr);
+        coalescedMutations += 2;
+        return;
+    }
+
+    itr->second.type = OpType::REMOVE;
+    ++coalescedMutations;
+}
+
+void ReforgeWriteQueue::DiscardOwner(uint32 guid)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (ReforgeOpContainer::iterator itr = reforgeOps.begin(); itr != reforgeOps.end(); )
+    {
+        if (itr->second.type != OpType::REMOVE && itr->second.data.guid == guid)
+            itr = reforgeOps.erase(itr);
+        else
+            ++itr;
+    }
+}
+
+bool ReforgeWriteQueue::HasPendingOwner(uint32 guid)
+{
+    // 包括已经取走但事务还没完成的修改
+    std::lock_guard<std::mutex> guard(lock);
+    for (const auto& [itemGuid, op] : reforgeOps)
+        if (op.data.guid == guid)
+            return true;
+
+    if (inFlightBatch)
+        for (const auto& [itemGuid, op] : inFlightBatch->ops)
+            if (op.data.guid == guid)
+                return true;
+
+    return false;
+}
+
+void ReforgeWriteQueue::AppendGenerationBump(CharacterDatabaseTransaction trans) const
+{
+    // 未启用快照或代数表不可用时不跟踪代数, 升级后的库里可能还没有这张表
+    if (generationTracking)
+        trans->Append(GetStatement(REFORGE_UPD_GENERATION));
+}
+
+void ReforgeWriteQueue::SetGenerationTracking(bool value)
+{
+    generationTracking = value;
+}
+
+bool ReforgeWriteQueue::IsGenerationTracking() const
+{
+    return generationTracking;
+}
+
+void ReforgeWriteQueue::SetGeneration(uint64 value)
+{
+    generation = value;
+}
+
+void ReforgeWriteQueue::AdvanceGeneration()
+{
+    if (generationTracking)
+        ++generation;
+}
+
+uint64 ReforgeWriteQueue::GetGeneration() const
+{
+    return generation;
+}
+
+bool ReforgeWriteQueue::TakePending(Batch& batch)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    if (reforgeOps.empty())
+        return false;
+
+    batch.ops.swap(reforgeOps);
+    return true;
+}
+
+void ReforgeWriteQueue::Requeue(const Batch& batch)
+{
+    std::lock_guard<std::mutex> guard(lock);
+    for (const auto& [itemGuid, op] : batch.ops)
+    {
+        // 失败后数据库状态未知, 插入按覆盖处理; 已有更新的修改则以新修改为准
+        ReforgeOp requeued = op;
+        if (requeued.type == OpType::INSERT)
+            requeued.type = OpType::UPSERT;
+        requeued.rowMayExist = true;
+
+        auto [itr, inserted] = reforgeOps.emplace(itemGuid, requeued);
+        if (inserted)
+            continue;
+
+        // 失败的修改被较新的修改遮住, 旧行可能仍在数据库里: 较新的插入改为覆盖写入, 之后的删除必须真正发出 DELETE
+        itr->second.rowMayExist = true;
+        if (itr->second.type == OpType::INSERT)
+            itr->second.type = OpType::UPSERT;
+    }
+}
+
+uint32 ReforgeWriteQueue::BuildTransaction(CharacterDatabaseTransaction trans, const Batch& batch) const
+{
+    uint32 statements = 0;
+    std::string replaceSql;
+    std::string deleteSql;
+    uint32 replaceRows = 0;
+    uint32 deleteRows = 0;
+
+    for (const auto& [itemGuid, op] : batch.ops)
+    {
+        if (op.type == OpType::REMOVE)
+        {
+            if (deleteRows > 0)
+                deleteSql += ", ";
+            else
+                deleteSql = GetStatement(REFORGE_DEL_CHARACTER_REFORGING);
+            deleteSql += Acore::ToString(itemGuid);
+
+            if (++deleteRows == MAX_ROWS_PER_STATEMENT)
+            {
+                trans->Append(deleteSql + ")");
+                ++statements;
+                deleteRows = 0;
+            }
+        }
+        else
+        {
+            if (replaceRows > 0)
+                replaceSql += ", ";
+            else
+                replaceSql = GetStatement(REFORGE_REP_CHARACTER_REFORGING);
+            replaceSql += Acore::StringFormat("({}, {}, {}, {}, {})", op.data.guid, op.data.item_guid, op.data.stat_decrease, op.data.stat_increase, op.data.stat_value);
+
+            if (++replaceRows == MAX_ROWS_PER_STATEMENT)
+            {
+                trans->Append(replaceSql);
+                ++statements;
+                replaceRows = 0;
+            }
+        }
+    }
+
+    if (deleteRows > 0)
+    {
+        trans->Append(deleteSql + ")");
+        ++statements;
+    }
+
+    if (replaceRows > 0)
+    {
+        trans->Append(replaceSql);
+        ++statements;
+    }
+
+    if (statements > 0)
+        AppendGenerationBump(trans);
+
+    return statements;
+}
+
+void ReforgeWriteQueue::Flush()
+{
+    std::shared_ptr<Batch> batch = std::make_shared<Batch>();
+    if (!TakePending(*batch))
+        return;
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    uint32 statements = BuildTransaction(trans, *batch);
+
+    uint32 startTime = getMSTime();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        inFlightBatch = batch;
+    }
+    inFlight = true;
+    callbacks.AddCallback(CharacterDatabase.AsyncCommitTransaction(trans)).AfterComplete([this, batch, statements, startTime](bool success)
+    {
+        inFlight = false;
+
+        if (!success)
+        {
+            ++failedFlushes;
+            LOG_ERROR("module", "mod_reforging: failed to write {} reforge changes, they will be retried on the next tick", batch->ops.size());
+            Requeue(*batch);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            inFlightBatch.reset();
+        }
+
+        if (!success)
+            return;
+
+        uint32 latency = GetMSTimeDiffToNow(startTime);
+        AdvanceGeneration();
+        ++flushes;
+        flushedMutations += batch->ops.size();
+        flushedStatements += statements;
+        lastFlushLatency = latency;
+        totalFlushLatency += latency;
+        if (latency > maxFlushLatency)
+            maxFlushLatency = latency;
+    });
+}
+
+void ReforgeWriteQueue::Update()
+{
+    callbacks.ProcessReadyCallbacks();
+
+    if (!inFlight)
+        Flush();
+}
+
+void ReforgeWriteQueue::FlushNow()
+{
+    uint32 startTime = getMSTime();
+    while (inFlight && GetMSTimeDiffToNow(startTime) < SHUTDOWN_WAIT_MS)
+    {
+        callbacks.ProcessReadyCallbacks();
+        if (inFlight)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    Batch batch;
+    if (!TakePending(batch))
+        return;
+
+    CharacterDatabaseTransaction trans = CharacterDatabase.BeginTransaction();
+    uint32 statements = BuildTransaction(trans, batch);
+    if (!CommitAndWait(trans))
+    {
+        ++failedFlushes;
+        LOG_ERROR("module", "mod_reforging: failed to write {} reforge changes on shutdown, they are lost", batch.ops.size());
+        return;
+    }
+
+    AdvanceGeneration();
+    ++flushes;
+    flushedMutations += batch.ops.size();
+    flushedStatements += statements;
+}
+
+/*static*/ bool ReforgeWriteQueue::CommitAndWait(CharacterDatabaseTransaction trans)
+{
+    // DirectCommitTransaction 不返回结果, 改为异步提交并等待完成
+    bool committed = false;
+    TransactionCallback callback = CharacterDatabase.AsyncCommitTransaction(trans);
+    callback.AfterComplete([&committed](bool success) { committed = success; });
+    while (!callback.InvokeIfReady())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    return committed;
+}
+
+uint32 ReforgeWriteQueue::GetQueueDepth()
+{
+    std::lock_guard<std::mutex> guard(lock);
+    return reforgeOps.size();
+}
+
+bool ReforgeWriteQueue::IsFlushInFlight() const
+{
+    return inFlight;
+}
+
+uint64 ReforgeWriteQueue::GetFlushCount() const
+{
+    return flushes;
+}
+
+uint64 ReforgeWriteQueue::GetFailedFlushCount() const
+{
+    return failedFlushes;
+}
+
+uint64 ReforgeWriteQueue::GetFlushedMutationCount() const
+{
+    return flushedMutations;
+}
+
+uint64 ReforgeWriteQueue::GetFlushedStatementCount() const
+{
+    return flushedStatements;
+}
+
+uint64 ReforgeWriteQueue::GetCoalescedMutationCount() const
+{
+    return coalescedMutations;
+}
+
+uint32 ReforgeWriteQueue::GetLastFlushLatency() const
+{
+    return lastFlushLatency;
+}
+
+uint32 ReforgeWriteQueue::GetMaxFlushLatency() const
+{
+    return maxFlushLatency;
+}
+
+uint32 ReforgeWriteQueue::GetAverageFlushLatency() const
+{
+    uint64 count = flushes;
+    if (count == 0)
+        return 0;
+
+    return uint32(totalFlushLatency / count);
+}
@@ -0,0 +1,111 @@
+/*
+ * Credits: silviu20092
+ */
+
+#ifndef _REFORGE_WRITE_QUEUE_H_
+#define _REFORGE_WRITE_QUEUE_H_
+
+#include "Define.h"
+#include "AsyncCallbackProcessor.h"
+#include "DatabaseEnv.h"
+#include "item_reforge.h"
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+class ReforgeWriteQueue
+{
+public:
+    enum ReforgeStatements : uint8
+    {
+        REFORGE_REP_CHARACTER_REFORGING,
+        REFORGE_DEL_CHARACTER_REFORGING,
+        REFORGE_UPD_GENERATION,
+        MAX_REFORGE_STATEMENTS
+    };
+private:
+    enum class OpType : uint8
+    {
+        INSERT,
+        UPSERT,
+        REMOVE
+    };
+
+    struct ReforgeOp
+    {
+        OpType type;
+        ItemReforge::ReforgingData data;
+        // 数据库里可能已有这一行(如替换了一个失败的删除), 之后的删除不能与插入抵消
+        bool rowMayExist;
+    };
+
+    typedef std::unordered_map<uint32, ReforgeOp> ReforgeOpContainer;
+
+    struct Batch
+    {
+        ReforgeOpContainer ops;
+    };
+
+    static constexpr uint32 MAX_ROWS_PER_STATEMENT = 500;
+    static constexpr uint32 SHUTDOWN_WAIT_MS = 10000;
+
+    std::mutex lock;
+    ReforgeOpContainer reforgeOps;
+    std::shared_ptr<Batch> inFlightBatch;
+
+    AsyncCallbackProcessor<TransactionCallback> callbacks;
+    std::atomic<bool> inFlight;
+    std::atomic<uint64> generation;
+    std::atomic<bool> generationTracking;
+
+    std::atomic<uint64> flushes;
+    std::atomic<uint64> failedFlushes;
+    std::atomic<uint64> flushedMutations;
+    std::atomic<uint64> flushedStatements;
+    std::atomic<uint64> coalescedMutations;
+    std::atomic<uint32> lastFlushLatency;
+    std::atomic<uint32> maxFlushLatency;
+    std::atomic<uint64> totalFlushLatency;
+
+    ReforgeWriteQueue();
+    ~ReforgeWriteQueue();
+
+    static const char* GetStatement(ReforgeStatements index);
+
+    uint32 BuildTransaction(CharacterDatabaseTransaction trans, const Batch& batch) const;
+    bool TakePending(Batch& batch);
+    void Requeue(const Batch& batch);
+    void Flush();
+public:
+    static ReforgeWriteQueue* instance();
+
+    void QueueReforge(const ItemReforge::ReforgingData& data);
+    void QueueRemove(uint32 itemGuid, uint32 guid);
+    void DiscardOwner(uint32 guid);
+    bool HasPendingOwner(uint32 guid);
+    void AppendGenerationBump(CharacterDatabaseTransaction trans) const;
+    void SetGenerationTracking(bool value);
+    bool IsGenerationTracking() const;
+    void SetGeneration(uint64 value);
+    void AdvanceGeneration();
+    uint64 GetGeneration() const;
+
+    void Update();
+    void FlushNow();
+    static bool CommitAndWait(CharacterDatabaseTransaction trans);
+
+    uint32 GetQueueDepth();
+    bool IsFlushInFlight() const;
+    uint64 GetFlushCount() const;
+    uint64 GetFailedFlushCount() const;
+    uint64 GetFlushedMutationCount() const;
+    uint64 GetFlushedStatementCount() const;
+    uint64 GetCoalescedMutationCount() const;
+    uint32 GetLastFlushLatency() const;
+    uint32 GetMaxFlushLatency() const;
+    uint32 GetAverageFlushLatency() const;
+};
+
+#define sReforgeWriteQueue ReforgeWriteQueue::instance()
+
+#endif